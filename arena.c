@@ -0,0 +1,251 @@
+#include "basic.h"
+
+// アリーナ（バンプアロケータ）
+//
+// 確保は先頭チャンクのポインタを進めるだけで、個別の解放は行わない。
+// arena_reset() で最初のチャンクを残して一括解放する。
+//
+// 個別に解放したい領域（文字列値やスタックフレーム）は arena_block_alloc() で
+// 確保する。小さなブロックはサイズクラス別のフリーリストで再利用し、
+// 大きなブロックはリストで追跡するため、いずれも arena_reset() で一括解放される。
+
+#define ARENA_ALIGN 16
+#define ARENA_ALIGN_UP(n) (((n) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct arena_chunk {
+    struct arena_chunk* next;   // 古いチャンクへ
+    size_t capacity;
+    size_t used;
+};
+
+#define ARENA_HEADER_SIZE ARENA_ALIGN_UP(sizeof(arena_chunk_t))
+
+// 大きなブロックの追跡リンク（ブロックヘッダの直前に置く）
+struct arena_large {
+    struct arena_large* prev;
+    struct arena_large* next;
+    void* raw;              // malloc/calloc の戻り値（整列前）
+};
+
+// ブロックヘッダ（ペイロードの直前、16バイト）
+typedef struct {
+    size_t size_class;      // ARENA_LARGE_CLASS なら大きなブロック
+    size_t size;            // 要求サイズ
+} block_header_t;
+
+#define ARENA_MIN_CLASS_SIZE 16
+#define ARENA_LARGE_CLASS ((size_t)-1)
+#define BLOCK_HEADER_SIZE ARENA_ALIGN_UP(sizeof(block_header_t))
+#define LARGE_LINK_SIZE ARENA_ALIGN_UP(sizeof(arena_large_t))
+
+static block_header_t* block_header(void* p) {
+    return (block_header_t*)((unsigned char*)p - BLOCK_HEADER_SIZE);
+}
+
+// 大きなブロックの確保（align は 16 の倍数の2の冪）
+// calloc は大きな領域でゼロページを割り当てるため、ゼロ初期化は実際に触れるまで遅延される
+static void* large_alloc(basic_arena_t* arena, size_t size, size_t align, bool zero) {
+    size_t overhead = LARGE_LINK_SIZE + BLOCK_HEADER_SIZE + (align - ARENA_ALIGN);
+    if (size > SIZE_MAX - overhead) return NULL;
+    unsigned char* raw = (unsigned char*)(zero ? calloc(1, overhead + size) : malloc(overhead + size));
+    if (!raw) return NULL;
+
+    uintptr_t first = (uintptr_t)(raw + LARGE_LINK_SIZE + BLOCK_HEADER_SIZE);
+    unsigned char* payload = (unsigned char*)((first + (align - 1)) & ~(uintptr_t)(align - 1));
+    block_header_t* header = block_header(payload);
+    arena_large_t* link = (arena_large_t*)((unsigned char*)header - LARGE_LINK_SIZE);
+    link->raw = raw;
+    link->prev = NULL;
+    link->next = arena->large;
+    if (arena->large) arena->large->prev = link;
+    arena->large = link;
+    header->size_class = ARENA_LARGE_CLASS;
+    header->size = size;
+    return payload;
+}
+
+static unsigned char* chunk_data(arena_chunk_t* chunk) {
+    return (unsigned char*)chunk + ARENA_HEADER_SIZE;
+}
+
+static arena_chunk_t* chunk_new(size_t capacity) {
+    arena_chunk_t* chunk = (arena_chunk_t*)malloc(ARENA_HEADER_SIZE + capacity);
+    if (!chunk) return NULL;
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+// 初期化（チャンクは最初の確保時に作成する）
+void arena_init(basic_arena_t* arena, size_t chunk_size) {
+    memset(arena, 0, sizeof(*arena));
+    arena->chunk_size = chunk_size;
+}
+
+// 確保（16バイト境界）
+void* arena_alloc(basic_arena_t* arena, size_t size) {
+    size = ARENA_ALIGN_UP(size ? size : 1);
+
+    arena_chunk_t* head = arena->head;
+    if (head && head->capacity - head->used >= size) {
+        void* p = chunk_data(head) + head->used;
+        head->used += size;
+        return p;
+    }
+
+    if (!head) {
+        head = chunk_new(arena->chunk_size);
+        if (!head) return NULL;
+        arena->head = head;
+        if (size <= head->capacity) {
+            head->used = size;
+            return chunk_data(head);
+        }
+    }
+
+    if (size > arena->chunk_size / 4) {
+        // 大きな確保は専用チャンクとし、現在のチャンクの残りを捨てない
+        arena_chunk_t* big = chunk_new(size);
+        if (!big) return NULL;
+        big->used = size;
+        big->next = head->next;
+        head->next = big;
+        return chunk_data(big);
+    }
+
+    arena_chunk_t* chunk = chunk_new(arena->chunk_size);
+    if (!chunk) return NULL;
+    chunk->used = size;
+    chunk->next = head;
+    arena->head = chunk;
+    return chunk_data(chunk);
+}
+
+// 文字列の複製（NUL終端）
+char* arena_strndup(basic_arena_t* arena, const char* src, size_t len) {
+    char* s = (char*)arena_alloc(arena, len + 1);
+    if (!s) return NULL;
+    if (len > 0) memcpy(s, src, len);
+    s[len] = '\0';
+    return s;
+}
+
+// サイズクラスの決定（16, 32, ... バイト）
+static size_t block_class(size_t size) {
+    size_t cls = 0;
+    size_t class_size = ARENA_MIN_CLASS_SIZE;
+    while (class_size < size) {
+        class_size <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+// 再利用可能ブロックの確保
+void* arena_block_alloc(basic_arena_t* arena, size_t size) {
+    size_t cls = block_class(size ? size : 1);
+
+    if (cls >= ARENA_SIZE_CLASSES) {
+        // 大きなブロックは malloc し、リセット時のためにリストで追跡する
+        return large_alloc(arena, size, ARENA_ALIGN, false);
+    }
+
+    void* p = arena->free_blocks[cls];
+    if (p) {
+        // フリーリストの次ポインタはペイロードに格納されている
+        arena->free_blocks[cls] = *(void**)p;
+    } else {
+        unsigned char* raw = (unsigned char*)arena_alloc(arena, BLOCK_HEADER_SIZE + ((size_t)ARENA_MIN_CLASS_SIZE << cls));
+        if (!raw) return NULL;
+        p = raw + BLOCK_HEADER_SIZE;
+    }
+    block_header_t* header = block_header(p);
+    header->size_class = cls;
+    header->size = size;
+    return p;
+}
+
+// 再利用可能ブロックの解放
+void arena_block_free(basic_arena_t* arena, void* p) {
+    if (!p) return;
+    block_header_t* header = block_header(p);
+    if (header->size_class == ARENA_LARGE_CLASS) {
+        arena_large_t* link = (arena_large_t*)((unsigned char*)header - LARGE_LINK_SIZE);
+        if (link->prev) link->prev->next = link->next;
+        else arena->large = link->next;
+        if (link->next) link->next->prev = link->prev;
+        free(link->raw);
+        return;
+    }
+    *(void**)p = arena->free_blocks[header->size_class];
+    arena->free_blocks[header->size_class] = p;
+}
+
+// 配列領域の確保（ゼロ初期化、ARENA_ARRAY_ALIGN バイト境界）
+// arena_block_free() で解放できる
+void* arena_array_alloc(basic_arena_t* arena, size_t count, size_t elem_size) {
+    if (elem_size != 0 && count > SIZE_MAX / elem_size) return NULL;
+    return large_alloc(arena, count * elem_size, ARENA_ARRAY_ALIGN, true);
+}
+
+// ブロックの要求サイズ
+size_t arena_block_size(const void* p) {
+    return p ? block_header((void*)p)->size : 0;
+}
+
+// ブロック単位の文字列複製（NUL終端）
+char* arena_block_strndup(basic_arena_t* arena, const char* src, size_t len) {
+    char* s = (char*)arena_block_alloc(arena, len + 1);
+    if (!s) return NULL;
+    if (len > 0) memcpy(s, src, len);
+    s[len] = '\0';
+    return s;
+}
+
+// 大きなブロックの一括解放とフリーリストの破棄
+static void release_blocks(basic_arena_t* arena) {
+    arena_large_t* link = arena->large;
+    while (link) {
+        arena_large_t* next = link->next;
+        free(link->raw);
+        link = next;
+    }
+    arena->large = NULL;
+    memset(arena->free_blocks, 0, sizeof(arena->free_blocks));
+}
+
+// リセット - 標準サイズのチャンクを1つだけ残して空にする
+void arena_reset(basic_arena_t* arena) {
+    release_blocks(arena);
+    arena_chunk_t* chunk = arena->head;
+    if (chunk && !chunk->next) {
+        chunk->used = 0;
+        return;
+    }
+    arena_chunk_t* keep = NULL;
+    while (chunk) {
+        arena_chunk_t* next = chunk->next;
+        if (!keep && chunk->capacity == arena->chunk_size) {
+            keep = chunk;
+            keep->next = NULL;
+            keep->used = 0;
+        } else {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    arena->head = keep;
+}
+
+// 全チャンクの解放
+void arena_release(basic_arena_t* arena) {
+    release_blocks(arena);
+    arena_chunk_t* chunk = arena->head;
+    while (chunk) {
+        arena_chunk_t* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+}
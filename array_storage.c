@@ -0,0 +1,192 @@
+#include "basic.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 配列の記憶方式（アリーナ上の連続領域以外）
+//
+//   DIM A(n) AS FILE "名前"   ファイルにマップした連続領域
+//   DIM A(n) AS SPARSE        代入された要素だけを持つ疎な配列
+//
+// 疎な配列は要素数が SPARSE_AUTO_ELEMENTS を超える DIM でも自動的に選ばれる。
+// 連続領域を前提とする MAT・配列関数・SORT では使えない。
+
+#define SPARSE_INITIAL_CAPACITY 64
+
+// ---- ファイルにマップした配列 ----
+//
+// 数値配列の要素をファイルの先頭から double の並びとしてマップする。
+// 代入はそのままファイルに反映され、ページ単位で読み書きされるのでメモリより大きなデータも扱える。
+// ファイルが短ければゼロで延長し、長ければ先頭部分だけを使う。マップは CLEAR/RUN/NEW で解除する。
+
+variable_t* create_file_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count,
+                              const char* path) {
+    if (strchr(name, '$')) {
+        set_error(state, ERR_TYPE_MISMATCH, "File arrays must be numeric");
+        return NULL;
+    }
+    size_t total = calculate_array_size(dimensions, dim_count);
+    if (total == ARRAY_INDEX_INVALID || total > SIZE_MAX / sizeof(numeric_value_t)) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    size_t length = total * sizeof(numeric_value_t);
+    if ((off_t)length < 0) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+
+    mapped_region_t* region = (mapped_region_t*)arena_alloc(&state->heap, sizeof(mapped_region_t));
+    if (!region) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return NULL;
+    }
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size < (off_t)length) ok = ftruncate(fd, (off_t)length) == 0;
+    void* addr = ok ? mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd); // マップはファイルを閉じても有効
+    if (addr == MAP_FAILED) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return NULL;
+    }
+
+    variable_t* var = install_array(state, name, dimensions, dim_count, addr, ARRAY_STORAGE_FILE);
+    if (!var) {
+        munmap(addr, length);
+        return NULL;
+    }
+    region->addr = addr;
+    region->length = length;
+    region->next = state->mapped_regions;
+    state->mapped_regions = region;
+    return var;
+}
+
+// マップの解除（書き込んだ内容はファイルに残る）
+void unmap_file_arrays(basic_state_t* state) {
+    for (mapped_region_t* region = state->mapped_regions; region; region = region->next) {
+        munmap(region->addr, region->length);
+    }
+    state->mapped_regions = NULL;
+}
+
+// ---- 疎な配列 ----
+// 未代入の要素は 0 または空文字列として読める。表は線形探査で、使用率が 3/4 を超えたら倍に広げる
+
+variable_t* create_sparse_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count) {
+    if (calculate_array_size(dimensions, dim_count) == ARRAY_INDEX_INVALID) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    sparse_table_t* table = (sparse_table_t*)arena_alloc(&state->heap, sizeof(sparse_table_t));
+    sparse_entry_t* entries = (sparse_entry_t*)arena_array_alloc(&state->heap, SPARSE_INITIAL_CAPACITY,
+                                                                 sizeof(sparse_entry_t));
+    if (!table || !entries) {
+        arena_block_free(&state->heap, entries);
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    table->entries = entries;
+    table->capacity = SPARSE_INITIAL_CAPACITY;
+    table->count = 0;
+
+    variable_t* var = install_array(state, name, dimensions, dim_count, table, ARRAY_STORAGE_SPARSE);
+    if (!var) arena_block_free(&state->heap, entries);
+    return var;
+}
+
+static size_t sparse_hash(size_t key, size_t capacity) {
+    uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 32)) & (capacity - 1);
+}
+
+// 線形添字 index の要素（未代入なら NULL）
+sparse_entry_t* sparse_find(const variable_t* var, size_t index) {
+    const sparse_table_t* table = (const sparse_table_t*)var->value.array.data;
+    size_t key = index + 1;
+    for (size_t i = sparse_hash(key, table->capacity); ; i = (i + 1) & (table->capacity - 1)) {
+        sparse_entry_t* entry = &table->entries[i];
+        if (entry->key == key) return entry;
+        if (entry->key == 0) return NULL;
+    }
+}
+
+static int sparse_grow(basic_state_t* state, sparse_table_t* table) {
+    if (table->capacity > SIZE_MAX / 2) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    size_t capacity = table->capacity * 2;
+    sparse_entry_t* entries = (sparse_entry_t*)arena_array_alloc(&state->heap, capacity, sizeof(sparse_entry_t));
+    if (!entries) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    for (size_t i = 0; i < table->capacity; i++) {
+        const sparse_entry_t* old = &table->entries[i];
+        if (old->key == 0) continue;
+        size_t j = sparse_hash(old->key, capacity);
+        while (entries[j].key != 0) j = (j + 1) & (capacity - 1);
+        entries[j] = *old;
+    }
+    arena_block_free(&state->heap, table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+    return 0;
+}
+
+// 線形添字 index の要素を取得、なければ値 0（空文字列）で追加
+sparse_entry_t* sparse_insert(basic_state_t* state, variable_t* var, size_t index) {
+    sparse_entry_t* entry = sparse_find(var, index);
+    if (entry) return entry;
+
+    sparse_table_t* table = (sparse_table_t*)var->value.array.data;
+    if ((table->count + 1) * 4 > table->capacity * 3 && sparse_grow(state, table) != 0) return NULL;
+
+    size_t key = index + 1;
+    size_t i = sparse_hash(key, table->capacity);
+    while (table->entries[i].key != 0) i = (i + 1) & (table->capacity - 1);
+    entry = &table->entries[i];
+    entry->key = key;
+    table->count++;
+    return entry;
+}
+
+// 形の変更（REDIM）- 表を作り直し、preserve なら新しい範囲に収まる要素を新しい添字で入れ直す
+// var は変更前の形のまま呼ぶこと
+int sparse_redimension(basic_state_t* state, variable_t* var, const size_t* dimensions, const size_t* strides,
+                       bool preserve) {
+    sparse_table_t* table = (sparse_table_t*)var->value.array.data;
+    size_t capacity = SPARSE_INITIAL_CAPACITY;
+    while (preserve && capacity * 3 < table->count * 4) capacity *= 2;
+
+    sparse_entry_t* entries = (sparse_entry_t*)arena_array_alloc(&state->heap, capacity, sizeof(sparse_entry_t));
+    if (!entries) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    sparse_entry_t* old_entries = table->entries;
+    size_t old_capacity = table->capacity;
+    table->entries = entries;
+    table->capacity = capacity;
+    table->count = 0;
+
+    for (size_t i = 0; preserve && i < old_capacity; i++) {
+        if (old_entries[i].key == 0) continue;
+        size_t index = remap_array_index(var, old_entries[i].key - 1, dimensions, strides);
+        if (index == ARRAY_INDEX_INVALID) continue;
+        // 容量は足りているので拡張は起きない
+        sparse_entry_t* entry = sparse_insert(state, var, index);
+        entry->value = old_entries[i].value;
+    }
+    arena_block_free(&state->heap, old_entries);
+    return 0;
+}
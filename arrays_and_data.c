@@ -8,170 +8,383 @@ extern variable_t* create_variable(basic_state_t* state, const char* name, varia
 extern token_t get_next_token(basic_state_t* state, parser_state_t* parser);
 extern eval_result_t evaluate_expression(basic_state_t* state, parser_state_t* parser);
 
-// データ文管理
-typedef struct data_entry {
-    char* value;
-    struct data_entry* next;
-} data_entry_t;
-
-typedef struct {
-    data_entry_t* data_list;
-    data_entry_t* current_data;
-} data_state_t;
-
-static data_state_t g_data_state = {NULL, NULL};
-
-// 配列の次元計算
-uint16_t calculate_array_size(uint16_t* dimensions, uint8_t dim_count) {
-    uint16_t total = 1;
+// 配列の次元計算（オーバーフロー時は ARRAY_INDEX_INVALID）
+size_t calculate_array_size(const size_t* dimensions, uint8_t dim_count) {
+    size_t total = 1;
     for (uint8_t i = 0; i < dim_count; i++) {
-        total *= (dimensions[i] + 1); // BASICは0ベースなので+1
+        if (dimensions[i] >= SIZE_MAX - 1) return ARRAY_INDEX_INVALID;
+        size_t extent = dimensions[i] + 1; // BASICは0ベースなので+1
+        if (total > SIZE_MAX / extent) return ARRAY_INDEX_INVALID;
+        total *= extent;
     }
     return total;
 }
 
-// 配列インデックスの計算
-uint16_t calculate_array_index(uint16_t* dimensions, uint8_t dim_count, uint16_t* indices) {
-    uint16_t index = 0;
-    uint16_t multiplier = 1;
-    
+// 各次元のストライドの計算（最後の添字が最も速く変化する）
+static void calculate_array_strides(const size_t* dimensions, uint8_t dim_count, size_t* strides) {
+    size_t stride = 1;
     for (int i = dim_count - 1; i >= 0; i--) {
+        strides[i] = stride;
+        stride *= (dimensions[i] + 1);
+    }
+}
+
+// 配列インデックスの計算（範囲外ならエラーを設定して ARRAY_INDEX_INVALID）
+static size_t array_element_index(basic_state_t* state, const variable_t* var,
+                                  const size_t* indices, uint8_t index_count) {
+    if (index_count != var->value.array.dim_count) {
+        set_error(state, ERR_SYNTAX, "Wrong number of dimensions");
+        return ARRAY_INDEX_INVALID;
+    }
+    
+    const size_t* dimensions = var->value.array.dimensions;
+    const size_t* strides = var->value.array.strides;
+    size_t index = 0;
+    for (uint8_t i = 0; i < index_count; i++) {
         if (indices[i] > dimensions[i]) {
-            return 0xFFFF; // エラー：範囲外
+            set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, NULL);
+            return ARRAY_INDEX_INVALID;
         }
-        index += indices[i] * multiplier;
-        multiplier *= (dimensions[i] + 1);
+        index += indices[i] * strides[i];
     }
-    
     return index;
 }
 
-// DIM文の実装
-int cmd_dim(basic_state_t* state, parser_state_t* parser_ptr) {
-    // DIM var(dim1, dim2, ...), var2(dim1, dim2, ...), ...
+// 文字列配列の要素のスロット（疎な配列で未代入なら、create が偽のとき NULL）
+static string_slot_t* string_slot(basic_state_t* state, const variable_t* var, size_t index, bool create) {
+    if (var->value.array.storage != ARRAY_STORAGE_SPARSE) {
+        return (string_slot_t*)var->value.array.data + index;
+    }
+    sparse_entry_t* entry = create ? sparse_insert(state, (variable_t*)var, index) : sparse_find(var, index);
+    return entry ? &entry->value.str : NULL;
+}
+
+// 文字列配列の要素取得（共有領域内を直接指す。次の代入まで有効）
+const char* string_array_get(const variable_t* var, size_t index, uint32_t* length) {
+    const string_slot_t* slot = string_slot(NULL, var, index, false);
+    const string_heap_t* heap = var->value.array.strings;
+    if (length) *length = slot ? slot->length : 0;
+    if (!slot || slot->offset == 0 || !heap->data) return "";
+    return heap->data + slot->offset;
+}
+
+// 文字列1つを新しい文字領域へ移す
+static void move_string(const string_heap_t* heap, char* data, size_t* used, string_slot_t* slot) {
+    if (slot->offset == 0) return;
+    memcpy(data + *used, heap->data + slot->offset, slot->length + 1);
+    slot->offset = (uint32_t)*used;
+    *used += slot->length + 1;
+}
+
+// 文字領域の確保 - 拡張時は生存している文字列だけを詰めて新しい領域へ移す
+static int string_heap_reserve(basic_state_t* state, variable_t* var, size_t extra) {
+    string_heap_t* heap = var->value.array.strings;
+    if (heap->data && heap->capacity - heap->used >= extra) return 0;
+    
+    size_t live = heap->used - heap->garbage;
+    if (live < 1) live = 1;
+    if (extra > UINT32_MAX - live) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    size_t capacity = (live + extra) * 2;
+    if (capacity < 256) capacity = 256;
+    if (capacity > UINT32_MAX) capacity = UINT32_MAX;
+    
+    char* data = (char*)arena_block_alloc(&state->heap, capacity);
+    if (!data) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    
+    // 先頭は空文字列
+    data[0] = '\0';
+    size_t used = 1;
+    if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+        sparse_table_t* table = (sparse_table_t*)var->value.array.data;
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->entries[i].key != 0) move_string(heap, data, &used, &table->entries[i].value.str);
+        }
+    } else {
+        string_slot_t* slots = (string_slot_t*)var->value.array.data;
+        for (size_t i = 0; i < var->value.array.total_elements; i++) {
+            move_string(heap, data, &used, &slots[i]);
+        }
+    }
+    
+    arena_block_free(&state->heap, heap->data);
+    heap->data = data;
+    heap->used = used;
+    heap->capacity = capacity;
+    heap->garbage = 0;
+    return 0;
+}
+
+// 文字列配列の要素設定（text は複製される）
+int string_array_set(basic_state_t* state, variable_t* var, size_t index, const char* text, size_t length) {
+    if (length > string_limit(state)) length = string_limit(state);
+    string_heap_t* heap = var->value.array.strings;
+    string_slot_t* slot = string_slot(state, var, index, length != 0);
+    
+    if (length == 0) {
+        if (!slot) return 0; // 疎な配列の未代入要素は既に空
+        if (slot->offset != 0) heap->garbage += slot->length + 1;
+        slot->offset = 0;
+        slot->length = 0;
+        return 0;
+    }
+    if (!slot) return -1;
+    
+    // 同じ長さ以下なら元の位置に上書き
+    if (slot->offset != 0 && length <= slot->length) {
+        memmove(heap->data + slot->offset, text, length);
+        heap->data[slot->offset + length] = '\0';
+        heap->garbage += slot->length - length;
+        slot->length = (uint32_t)length;
+        return 0;
+    }
+    
+    // text が自身の文字領域を指している場合に備えて、拡張前に一時領域へ退避
+    if (heap->data && text >= heap->data && text < heap->data + heap->capacity) {
+        text = scratch_string(state, text, length);
+        if (!text) return -1;
+    }
+    if (string_heap_reserve(state, var, length + 1) != 0) return -1;
+    heap = var->value.array.strings;
+    slot = string_slot(state, var, index, false);
+    
+    if (slot->offset != 0) heap->garbage += slot->length + 1;
+    memcpy(heap->data + heap->used, text, length);
+    heap->data[heap->used + length] = '\0';
+    slot->offset = (uint32_t)heap->used;
+    slot->length = (uint32_t)length;
+    heap->used += length + 1;
+    return 0;
+}
+
+// 添字リストの解析 - 開き括弧の直後から閉じ括弧までを読む
+int parse_array_subscripts(basic_state_t* state, parser_state_t* parser_ptr,
+                           size_t* indices, uint8_t* index_count) {
+    *index_count = 0;
     
     while (true) {
-        // 変数名の取得
-        token_t var_token = get_next_token(state, parser_ptr);
-        if (var_token.type != TOKEN_VARIABLE) {
-            set_error(state, ERR_SYNTAX, "Variable name expected in DIM");
+        if (*index_count >= MAX_ARRAY_DIMENSIONS) {
+            set_error(state, ERR_SYNTAX, "Too many dimensions");
             return -1;
         }
         
-        // 既存変数チェック
-        // 既存変数チェック（同名が存在すればエラー）
-        variable_t* existing_var = find_variable(state, var_token.value.string); if (existing_var) { set_error(state, ERR_REDIMENSIONED_ARRAY, NULL); free(var_token.value.string); return -1; }
-        token_t open_paren = get_next_token(state, parser_ptr);
-        if (open_paren.type != TOKEN_DELIMITER || open_paren.value.operator != '(') {
-            set_error(state, ERR_SYNTAX, "( expected in DIM");
-            free(var_token.value.string);
+        eval_result_t index_result = evaluate_expression(state, parser_ptr);
+        if (has_error(state) || index_result.type != 0) {
+            set_error(state, ERR_TYPE_MISMATCH, "Numeric index expected");
             return -1;
         }
         
-        // 次元の読み取り
-        uint16_t dimensions[MAX_ARRAY_DIMENSIONS];
-        uint8_t dim_count = 0;
-        
-        while (dim_count < MAX_ARRAY_DIMENSIONS) {
-            eval_result_t dim_result = evaluate_expression(state, parser_ptr);
-            if (has_error(state) || dim_result.type != 0) {
-                set_error(state, ERR_TYPE_MISMATCH, "Numeric dimension expected");
-                free(var_token.value.string);
-                return -1;
-            }
-            
-            int dim_val = (int)numeric_to_double(dim_result.value.num);
-            if (dim_val < 0) {
-                set_error(state, ERR_ILLEGAL_QUANTITY, "Negative dimension");
-                free(var_token.value.string);
-                return -1;
-            }
-            
-            dimensions[dim_count++] = (uint16_t)dim_val;
-            
-            token_t next_token = get_next_token(state, parser_ptr);
-            if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') {
-                continue; // 次の次元へ
-            } else if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ')') {
-                break; // 次元定義終了
-            } else {
-                set_error(state, ERR_SYNTAX, ", or ) expected in DIM");
-                free(var_token.value.string);
-                return -1;
-            }
+        double index = trunc(numeric_to_double(index_result.value.num));
+        if (!(index >= 0) || index >= (double)SIZE_MAX) {
+            set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, NULL);
+            return -1;
         }
+        indices[(*index_count)++] = (size_t)index;
         
-        if (dim_count == 0) {
-            set_error(state, ERR_SYNTAX, "At least one dimension required");
-            free(var_token.value.string);
+        token_t sep_token = get_next_token(state, parser_ptr);
+        if (sep_token.type == TOKEN_DELIMITER && sep_token.value.operator == ',') {
+            continue; // 次のインデックスへ
+        } else if (sep_token.type == TOKEN_DELIMITER && sep_token.value.operator == ')') {
+            return 0; // インデックス終了
+        } else {
+            set_error(state, ERR_SYNTAX, ", or ) expected in array access");
+            return -1;
+        }
+    }
+}
+
+// 配列変数の作成（DIM と MAT の結果配列で共用）
+// 領域はゼロ初期化済み（数値は 0.0、文字列はオフセット0 = 空文字列）
+// 文字列配列の文字領域は最初の代入時に確保する
+variable_t* create_array(basic_state_t* state, const char* name,
+                         const size_t* dimensions, uint8_t dim_count) {
+    bool is_string = strchr(name, '$') != NULL;
+    size_t total_elements = calculate_array_size(dimensions, dim_count);
+    size_t elem_size = is_string ? sizeof(string_slot_t) : sizeof(numeric_value_t);
+    void* data = NULL;
+    if (total_elements != ARRAY_INDEX_INVALID) {
+        data = arena_array_alloc(&state->heap, total_elements, elem_size);
+    }
+    if (!data) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    
+    variable_t* array_var = install_array(state, name, dimensions, dim_count, data, ARRAY_STORAGE_ARENA);
+    if (!array_var) arena_block_free(&state->heap, data);
+    return array_var;
+}
+
+// 確保済みの要素領域から配列変数を作る（失敗時の data の解放は呼び出し側で行う）
+variable_t* install_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count,
+                          void* data, array_storage_t storage) {
+    bool is_string = strchr(name, '$') != NULL;
+    size_t* dims = (size_t*)arena_alloc(&state->heap, 2 * dim_count * sizeof(size_t));
+    string_heap_t* strings = NULL;
+    if (is_string) {
+        strings = (string_heap_t*)arena_alloc(&state->heap, sizeof(string_heap_t));
+        if (strings) memset(strings, 0, sizeof(string_heap_t));
+    }
+    if (!dims || (is_string && !strings)) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    memcpy(dims, dimensions, dim_count * sizeof(size_t));
+    calculate_array_strides(dims, dim_count, dims + dim_count);
+    
+    variable_type_t var_type = is_string ? VAR_ARRAY_STRING : VAR_ARRAY_NUMERIC;
+    variable_t* array_var = create_variable(state, name, var_type);
+    if (!array_var) return NULL;
+    
+    array_var->value.array.data = data;
+    array_var->value.array.dimensions = dims;
+    array_var->value.array.strides = dims + dim_count;
+    array_var->value.array.dim_count = dim_count;
+    array_var->value.array.total_elements = calculate_array_size(dims, dim_count);
+    array_var->value.array.capacity = array_var->value.array.total_elements;
+    array_var->value.array.strings = strings;
+    array_var->value.array.storage = storage;
+    return array_var;
+}
+
+// 配列名のトークンから配列変数を解決（MAT文・配列関数・SORTで共用）
+// いずれも要素の連続領域を直接扱うため、疎な配列はエラーにする
+variable_t* resolve_array(basic_state_t* state, token_t token, bool numeric_only) {
+    if (token.type != TOKEN_VARIABLE) {
+        set_error(state, ERR_SYNTAX, "Array name expected");
+        return NULL;
+    }
+    variable_t* var = find_variable(state, token.value.string);
+    if (!var || (var->type != VAR_ARRAY_NUMERIC && var->type != VAR_ARRAY_STRING)) {
+        set_error(state, ERR_UNDEF_STATEMENT, "Array not found");
+        return NULL;
+    }
+    if (numeric_only && var->type != VAR_ARRAY_NUMERIC) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return NULL;
+    }
+    if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+        set_error(state, ERR_TYPE_MISMATCH, "Sparse array not allowed here");
+        return NULL;
+    }
+    return var;
+}
+
+// 次元リスト「(d1, d2, ...)」の解析（DIM と REDIM で共用）
+static int parse_dimensions(basic_state_t* state, parser_state_t* parser_ptr,
+                            size_t* dimensions, uint8_t* dim_count) {
+    token_t open_paren = get_next_token(state, parser_ptr);
+    if (open_paren.type != TOKEN_DELIMITER || open_paren.value.operator != '(') {
+        set_error(state, ERR_SYNTAX, "( expected in DIM");
+        return -1;
+    }
+    
+    *dim_count = 0;
+    while (*dim_count < MAX_ARRAY_DIMENSIONS) {
+        eval_result_t dim_result = evaluate_expression(state, parser_ptr);
+        if (has_error(state) || dim_result.type != 0) {
+            set_error(state, ERR_TYPE_MISMATCH, "Numeric dimension expected");
             return -1;
         }
         
-        // 配列変数の作成
-        bool is_string = strchr(var_token.value.string, '$') != NULL;
-        variable_type_t var_type = is_string ? VAR_ARRAY_STRING : VAR_ARRAY_NUMERIC;
-        
-        variable_t* array_var = create_variable(state, var_token.value.string, var_type);
-        if (!array_var) {
-            free(var_token.value.string);
+        double dim_val = trunc(numeric_to_double(dim_result.value.num));
+        if (dim_val < 0) {
+            set_error(state, ERR_ILLEGAL_QUANTITY, "Negative dimension");
+            return -1;
+        }
+        if (!(dim_val < (double)SIZE_MAX)) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
             return -1;
         }
         
-        // 配列データの割り当て
-        uint16_t total_elements = calculate_array_size(dimensions, dim_count);
+        dimensions[(*dim_count)++] = (size_t)dim_val;
         
-        array_var->value.array.dimensions = (uint16_t*)malloc(dim_count * sizeof(uint16_t));
-        if (!array_var->value.array.dimensions) {
-            set_error(state, ERR_OUT_OF_MEMORY, NULL);
-            free(var_token.value.string);
+        token_t next_token = get_next_token(state, parser_ptr);
+        if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') {
+            continue; // 次の次元へ
+        } else if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ')') {
+            return 0; // 次元定義終了
+        } else {
+            set_error(state, ERR_SYNTAX, ", or ) expected in DIM");
+            return -1;
+        }
+    }
+    
+    set_error(state, ERR_SYNTAX, "Too many dimensions");
+    return -1;
+}
+
+// DIM文の実装
+int cmd_dim(basic_state_t* state, parser_state_t* parser_ptr) {
+    // DIM var(dim1, dim2, ...), var2(dim1, dim2, ...), ...
+    
+    while (true) {
+        // 変数名の取得
+        token_t var_token = get_next_token(state, parser_ptr);
+        if (var_token.type != TOKEN_VARIABLE) {
+            set_error(state, ERR_SYNTAX, "Variable name expected in DIM");
             return -1;
         }
         
-        memcpy(array_var->value.array.dimensions, dimensions, dim_count * sizeof(uint16_t));
-        array_var->value.array.dim_count = dim_count;
-        array_var->value.array.total_elements = total_elements;
+        // 既存変数チェック
+        // 既存変数チェック（同名が存在すればエラー）
+        variable_t* existing_var = find_variable(state, var_token.value.string); if (existing_var) { set_error(state, ERR_REDIMENSIONED_ARRAY, NULL); return -1; }
         
-        if (is_string) {
-            // 文字列配列
-            char** string_array = (char**)malloc(total_elements * sizeof(char*));
-            if (!string_array) {
-                set_error(state, ERR_OUT_OF_MEMORY, NULL);
-                free(array_var->value.array.dimensions);
-                free(var_token.value.string);
+        // 連想配列（DIM M AS MAP）
+        uint16_t save = parser_ptr->position;
+        token_t as_token = get_next_token(state, parser_ptr);
+        if (as_token.type == TOKEN_VARIABLE && strcmp(as_token.value.string, "AS") == 0) {
+            token_t kind = get_next_token(state, parser_ptr);
+            if (kind.type != TOKEN_VARIABLE || strcmp(kind.value.string, "MAP") != 0) {
+                set_error(state, ERR_SYNTAX, "MAP expected after AS");
                 return -1;
             }
-            
-            // 空文字列で初期化
-            for (uint16_t i = 0; i < total_elements; i++) {
-                string_array[i] = (char*)malloc(1);
-                if (string_array[i]) {
-                    string_array[i][0] = '\0';
+            if (!create_map(state, var_token.value.string)) return -1;
+            token_t next_token = get_next_token(state, parser_ptr);
+            if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') continue;
+            break;
+        }
+        parser_rewind(parser_ptr, save);
+        
+        size_t dimensions[MAX_ARRAY_DIMENSIONS];
+        uint8_t dim_count = 0;
+        if (parse_dimensions(state, parser_ptr, dimensions, &dim_count) != 0) return -1;
+        
+        // 記憶方式の指定（AS FILE "名前" / AS SPARSE）、巨大な配列は自動的に疎な配列にする
+        token_t next_token = get_next_token(state, parser_ptr);
+        variable_t* array_var;
+        if (next_token.type == TOKEN_VARIABLE && strcmp(next_token.value.string, "AS") == 0) {
+            token_t kind = get_next_token(state, parser_ptr);
+            if (kind.type == TOKEN_VARIABLE && strcmp(kind.value.string, "SPARSE") == 0) {
+                array_var = create_sparse_array(state, var_token.value.string, dimensions, dim_count);
+            } else if (kind.type == TOKEN_VARIABLE && strcmp(kind.value.string, "FILE") == 0) {
+                token_t path = get_next_token(state, parser_ptr);
+                if (path.type != TOKEN_STRING) {
+                    set_error(state, ERR_SYNTAX, "File name expected");
+                    return -1;
                 }
-            }
-            
-            array_var->value.array.data = string_array;
-        } else {
-            // 数値配列
-            numeric_value_t* numeric_array = (numeric_value_t*)malloc(total_elements * sizeof(numeric_value_t));
-            if (!numeric_array) {
-                set_error(state, ERR_OUT_OF_MEMORY, NULL);
-                free(array_var->value.array.dimensions);
-                free(var_token.value.string);
+                array_var = create_file_array(state, var_token.value.string, dimensions, dim_count, path.value.string);
+            } else {
+                set_error(state, ERR_SYNTAX, "FILE or SPARSE expected after AS");
                 return -1;
             }
-            
-            // 0で初期化
-            for (uint16_t i = 0; i < total_elements; i++) {
-                numeric_array[i] = double_to_numeric(0.0);
+            next_token = get_next_token(state, parser_ptr);
+        } else {
+            size_t total = calculate_array_size(dimensions, dim_count);
+            if (total != ARRAY_INDEX_INVALID && total > SPARSE_AUTO_ELEMENTS) {
+                array_var = create_sparse_array(state, var_token.value.string, dimensions, dim_count);
+            } else {
+                array_var = create_array(state, var_token.value.string, dimensions, dim_count);
             }
-            
-            array_var->value.array.data = numeric_array;
         }
-        
-        free(var_token.value.string);
+        if (!array_var) return -1;
         
         // 次の変数があるかチェック
-        token_t next_token = get_next_token(state, parser_ptr);
         if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') {
             continue; // 次の変数へ
         } else {
@@ -182,61 +395,293 @@ int cmd_dim(basic_state_t* state, parser_state_t* parser_ptr) {
     return 0;
 }
 
-// 配列要素のアクセス
-eval_result_t access_array_element(basic_state_t* state, const char* var_name, 
-                                  uint16_t* indices, uint8_t index_count) {
+// 要素1つの大きさ
+static size_t array_element_size(const variable_t* var) {
+    return var->type == VAR_ARRAY_STRING ? sizeof(string_slot_t) : sizeof(numeric_value_t);
+}
+
+// 変更前の形での線形添字 index を新しい形での線形添字へ（新しい範囲外なら ARRAY_INDEX_INVALID）
+// 次元数は変わらないこと
+size_t remap_array_index(const variable_t* var, size_t index, const size_t* dimensions, const size_t* strides) {
+    size_t result = 0;
+    for (uint8_t i = 0; i < var->value.array.dim_count; i++) {
+        size_t subscript = index / var->value.array.strides[i];
+        index %= var->value.array.strides[i];
+        if (subscript > dimensions[i]) return ARRAY_INDEX_INVALID;
+        result += subscript * strides[i];
+    }
+    return result;
+}
+
+// 連続領域を capacity 要素以上に広げる（先頭 total_elements 要素を保持）
+// 確保済みで未使用の要素は常にゼロにしておく
+static int reserve_array_storage(basic_state_t* state, variable_t* var, size_t capacity) {
+    if (capacity <= var->value.array.capacity) return 0;
+    size_t elem_size = array_element_size(var);
+    void* data = arena_array_alloc(&state->heap, capacity, elem_size);
+    if (!data) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    memcpy(data, var->value.array.data, var->value.array.total_elements * elem_size);
+    arena_block_free(&state->heap, var->value.array.data);
+    var->value.array.data = data;
+    var->value.array.capacity = capacity;
+    return 0;
+}
+
+// 連続領域の配列の形の変更
+static int redimension_dense(basic_state_t* state, variable_t* var, const size_t* dimensions,
+                             const size_t* strides, uint8_t dim_count, size_t total, bool preserve) {
+    size_t elem_size = array_element_size(var);
+    size_t old_total = var->value.array.total_elements;
+    char* data = (char*)var->value.array.data;
+    
+    // 先頭の次元だけが変わるなら線形添字は変わらないので、先頭部分をそのまま残せる
+    bool same_rows = (dim_count == var->value.array.dim_count);
+    for (uint8_t i = 1; same_rows && i < dim_count; i++) {
+        if (dimensions[i] != var->value.array.dimensions[i]) same_rows = false;
+    }
+    
+    if (preserve && !same_rows) {
+        char* moved = (char*)arena_array_alloc(&state->heap, total, elem_size);
+        if (!moved) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
+            return -1;
+        }
+        for (size_t i = 0; i < old_total; i++) {
+            size_t j = remap_array_index(var, i, dimensions, strides);
+            if (j != ARRAY_INDEX_INVALID) memcpy(moved + j * elem_size, data + i * elem_size, elem_size);
+        }
+        arena_block_free(&state->heap, data);
+        var->value.array.data = moved;
+        var->value.array.capacity = total;
+        return 0;
+    }
+    
+    if (!preserve) {
+        memset(data, 0, old_total * elem_size);
+        var->value.array.total_elements = 0;
+    } else if (total < old_total) {
+        memset(data + total * elem_size, 0, (old_total - total) * elem_size);
+    }
+    return reserve_array_storage(state, var, total);
+}
+
+// 文字列配列の不要バイト数の数え直し（要素を捨てた後）
+static void recount_string_garbage(variable_t* var) {
+    string_heap_t* heap = var->value.array.strings;
+    if (!heap->data) return;
+    size_t live = 1;
+    if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+        const sparse_table_t* table = (const sparse_table_t*)var->value.array.data;
+        for (size_t i = 0; i < table->capacity; i++) {
+            const sparse_entry_t* entry = &table->entries[i];
+            if (entry->key != 0 && entry->value.str.offset != 0) live += entry->value.str.length + 1;
+        }
+    } else {
+        const string_slot_t* slots = (const string_slot_t*)var->value.array.data;
+        for (size_t i = 0; i < var->value.array.total_elements; i++) {
+            if (slots[i].offset != 0) live += slots[i].length + 1;
+        }
+    }
+    heap->garbage = heap->used - live;
+}
+
+// 配列の形の変更（preserve なら同じ添字の要素を残し、それ以外はすべて 0 / 空文字列にする）
+static int redimension_array(basic_state_t* state, variable_t* var,
+                             const size_t* dimensions, uint8_t dim_count, bool preserve) {
+    if (var->value.array.storage == ARRAY_STORAGE_FILE) {
+        set_error(state, ERR_REDIMENSIONED_ARRAY, "File arrays cannot be redimensioned");
+        return -1;
+    }
+    if (preserve && dim_count != var->value.array.dim_count) {
+        set_error(state, ERR_REDIMENSIONED_ARRAY, "PRESERVE cannot change the number of dimensions");
+        return -1;
+    }
+    size_t total = calculate_array_size(dimensions, dim_count);
+    if (total == ARRAY_INDEX_INVALID) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    size_t strides[MAX_ARRAY_DIMENSIONS];
+    calculate_array_strides(dimensions, dim_count, strides);
+    
+    size_t* dims = var->value.array.dimensions;
+    if (dim_count != var->value.array.dim_count) {
+        dims = (size_t*)arena_alloc(&state->heap, 2 * dim_count * sizeof(size_t));
+        if (!dims) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
+            return -1;
+        }
+    }
+    
+    int rc;
+    if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+        rc = sparse_redimension(state, var, dimensions, strides, preserve);
+    } else {
+        rc = redimension_dense(state, var, dimensions, strides, dim_count, total, preserve);
+    }
+    if (rc != 0) return -1;
+    
+    memcpy(dims, dimensions, dim_count * sizeof(size_t));
+    memcpy(dims + dim_count, strides, dim_count * sizeof(size_t));
+    var->value.array.dimensions = dims;
+    var->value.array.strides = dims + dim_count;
+    var->value.array.dim_count = dim_count;
+    var->value.array.total_elements = total;
+    
+    if (var->type == VAR_ARRAY_STRING) {
+        if (preserve) {
+            recount_string_garbage(var);
+        } else {
+            string_heap_t* heap = var->value.array.strings;
+            arena_block_free(&state->heap, heap->data);
+            memset(heap, 0, sizeof(string_heap_t));
+        }
+    }
+    return 0;
+}
+
+// REDIM文の実装 - REDIM [PRESERVE] A(d1, ...), B$(...), ...
+// 未定義の配列は DIM と同様に作成する
+int cmd_redim(basic_state_t* state, parser_state_t* parser_ptr) {
+    token_t var_token = get_next_token(state, parser_ptr);
+    bool preserve = var_token.type == TOKEN_VARIABLE && strcmp(var_token.value.string, "PRESERVE") == 0;
+    if (preserve) var_token = get_next_token(state, parser_ptr);
+    
+    while (true) {
+        if (var_token.type != TOKEN_VARIABLE) {
+            set_error(state, ERR_SYNTAX, "Variable name expected in REDIM");
+            return -1;
+        }
+        size_t dimensions[MAX_ARRAY_DIMENSIONS];
+        uint8_t dim_count = 0;
+        if (parse_dimensions(state, parser_ptr, dimensions, &dim_count) != 0) return -1;
+        
+        variable_t* var = find_variable(state, var_token.value.string);
+        if (!var) {
+            if (!create_array(state, var_token.value.string, dimensions, dim_count)) return -1;
+        } else if (var->type != VAR_ARRAY_NUMERIC && var->type != VAR_ARRAY_STRING) {
+            set_error(state, ERR_TYPE_MISMATCH, NULL);
+            return -1;
+        } else if (redimension_array(state, var, dimensions, dim_count, preserve) != 0) {
+            return -1;
+        }
+        
+        uint16_t save = parser_ptr->position;
+        token_t next_token = get_next_token(state, parser_ptr);
+        if (next_token.type != TOKEN_DELIMITER || next_token.value.operator != ',') {
+            parser_rewind(parser_ptr, save);
+            return 0;
+        }
+        var_token = get_next_token(state, parser_ptr);
+    }
+}
+
+// APPEND文の実装 - APPEND A, 値
+// 1次元配列の末尾に要素を1つ追加する（配列がなければ1要素で作成）。
+// 確保量は倍々に増やすので、追加は償却 O(1)
+int cmd_append(basic_state_t* state, parser_state_t* parser_ptr) {
+    token_t var_token = get_next_token(state, parser_ptr);
+    if (var_token.type != TOKEN_VARIABLE) {
+        set_error(state, ERR_SYNTAX, "Array name expected");
+        return -1;
+    }
+    token_t comma = get_next_token(state, parser_ptr);
+    if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') {
+        set_error(state, ERR_SYNTAX, ", expected");
+        return -1;
+    }
+    eval_result_t value = evaluate_expression(state, parser_ptr);
+    if (has_error(state)) return -1;
+    bool is_string = strchr(var_token.value.string, '$') != NULL;
+    if (value.type != (is_string ? 1 : 0)) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return -1;
+    }
+    
+    size_t index = 0;
+    variable_t* var = find_variable(state, var_token.value.string);
+    if (!var) {
+        var = create_array(state, var_token.value.string, &index, 1);
+        if (!var) return -1;
+    } else {
+        if (var->type != VAR_ARRAY_NUMERIC && var->type != VAR_ARRAY_STRING) {
+            set_error(state, ERR_TYPE_MISMATCH, NULL);
+            return -1;
+        }
+        if (var->value.array.dim_count != 1) {
+            set_error(state, ERR_SYNTAX, "One-dimensional array expected");
+            return -1;
+        }
+        if (var->value.array.storage == ARRAY_STORAGE_FILE) {
+            set_error(state, ERR_REDIMENSIONED_ARRAY, "File arrays cannot be redimensioned");
+            return -1;
+        }
+        index = var->value.array.total_elements;
+        if (index >= SIZE_MAX / 2) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
+            return -1;
+        }
+        if (var->value.array.storage == ARRAY_STORAGE_ARENA && index >= var->value.array.capacity) {
+            size_t capacity = var->value.array.capacity < 8 ? 8 : var->value.array.capacity * 2;
+            if (reserve_array_storage(state, var, capacity) != 0) return -1;
+        }
+        var->value.array.dimensions[0] = index;
+        var->value.array.total_elements = index + 1;
+    }
+    
+    return assign_array_element(state, var, &index, 1, value);
+}
+
+// 配列要素のアクセス（var は呼び出し側で解決済みの配列変数）
+eval_result_t access_array_element(basic_state_t* state, variable_t* var,
+                                  const size_t* indices, uint8_t index_count) {
     eval_result_t result = {0};
     
-    variable_t* var = find_variable(state, var_name);
     if (!var || (var->type != VAR_ARRAY_NUMERIC && var->type != VAR_ARRAY_STRING)) {
         set_error(state, ERR_UNDEF_STATEMENT, "Array not found");
         return result;
     }
     
-    if (index_count != var->value.array.dim_count) {
-        set_error(state, ERR_SYNTAX, "Wrong number of dimensions");
-        return result;
-    }
-    
-    uint16_t array_index = calculate_array_index(var->value.array.dimensions, 
-                                                var->value.array.dim_count, indices);
-    if (array_index == 0xFFFF) {
-        set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, NULL);
+    size_t array_index = array_element_index(state, var, indices, index_count);
+    if (array_index == ARRAY_INDEX_INVALID) {
         return result;
     }
     
     if (var->type == VAR_ARRAY_NUMERIC) {
         result.type = 0; // 数値
-        numeric_value_t* numeric_array = (numeric_value_t*)var->value.array.data;
-        result.value.num = numeric_array[array_index];
+        if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+            const sparse_entry_t* entry = sparse_find(var, array_index);
+            result.value.num = entry ? entry->value.num : double_to_numeric(0.0);
+        } else {
+            numeric_value_t* numeric_array = (numeric_value_t*)var->value.array.data;
+            result.value.num = numeric_array[array_index];
+        }
     } else {
         result.type = 1; // 文字列
-        char** string_array = (char**)var->value.array.data;
-        result.value.str.data = safe_string_dup(string_array[array_index], MAX_STRING_LENGTH);
-        result.value.str.length = result.value.str.data ? strlen(result.value.str.data) : 0;
+        uint32_t length = 0;
+        const char* text = string_array_get(var, array_index, &length);
+        size_t len = length;
+        if (len > string_limit(state)) len = string_limit(state);
+        result.value.str.data = scratch_string(state, text, len);
+        result.value.str.length = result.value.str.data ? (uint32_t)len : 0;
     }
     
     return result;
 }
 
-// 配列要素への代入
-int assign_array_element(basic_state_t* state, const char* var_name, 
-                        uint16_t* indices, uint8_t index_count, eval_result_t value) {
-    variable_t* var = find_variable(state, var_name);
+// 配列要素への代入（var は呼び出し側で解決済みの配列変数）
+int assign_array_element(basic_state_t* state, variable_t* var,
+                        const size_t* indices, uint8_t index_count, eval_result_t value) {
     if (!var || (var->type != VAR_ARRAY_NUMERIC && var->type != VAR_ARRAY_STRING)) {
         set_error(state, ERR_UNDEF_STATEMENT, "Array not found");
         return -1;
     }
     
-    if (index_count != var->value.array.dim_count) {
-        set_error(state, ERR_SYNTAX, "Wrong number of dimensions");
-        return -1;
-    }
-    
-    uint16_t array_index = calculate_array_index(var->value.array.dimensions, 
-                                                var->value.array.dim_count, indices);
-    if (array_index == 0xFFFF) {
-        set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, NULL);
+    size_t array_index = array_element_index(state, var, indices, index_count);
+    if (array_index == ARRAY_INDEX_INVALID) {
         return -1;
     }
     
@@ -245,79 +690,200 @@ int assign_array_element(basic_state_t* state, const char* var_name,
             set_error(state, ERR_TYPE_MISMATCH, NULL);
             return -1;
         }
-        numeric_value_t* numeric_array = (numeric_value_t*)var->value.array.data;
-        numeric_array[array_index] = value.value.num;
+        if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+            // 未代入の要素への 0 の代入は表に追加しない
+            if (numeric_to_double(value.value.num) == 0.0 && !sparse_find(var, array_index)) return 0;
+            sparse_entry_t* entry = sparse_insert(state, var, array_index);
+            if (!entry) return -1;
+            entry->value.num = value.value.num;
+        } else {
+            numeric_value_t* numeric_array = (numeric_value_t*)var->value.array.data;
+            numeric_array[array_index] = value.value.num;
+        }
     } else {
         if (value.type != 1) {
             set_error(state, ERR_TYPE_MISMATCH, NULL);
             return -1;
         }
-        char** string_array = (char**)var->value.array.data;
-        if (string_array[array_index]) {
-            free(string_array[array_index]);
-        }
-        string_array[array_index] = value.value.str.data;
+        // 一時領域の文字列を配列の文字領域へ複製
+        const char* text = value.value.str.data;
+        return string_array_set(state, var, array_index, text ? text : "", text ? strlen(text) : 0);
     }
     
     return 0;
 }
 
-// DATA文の実装
-int cmd_data(basic_state_t* state, parser_state_t* parser_ptr) {
+// ---- DATA文 ----
+// RUN 時にプログラム全体を一度走査し、DATA の値をプログラム順の連続した表にする。
+// READ は表の位置を進めるだけで、DATA 行の実行を待たずに読める。
+// 行ごとの先頭位置も記録し、RESTORE 行番号 はそこへ位置を戻す。
+
+#define DATA_INITIAL_CAPACITY 64
+
+// 表の拡張（要素数 count が容量に達していれば倍にする）
+static int data_reserve(basic_state_t* state, void** items, size_t* capacity, size_t count, size_t elem_size) {
+    if (count < *capacity) return 0;
+    size_t new_capacity = *capacity ? *capacity * 2 : DATA_INITIAL_CAPACITY;
+    void* grown = arena_array_alloc(&state->heap, new_capacity, elem_size);
+    if (!grown) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    if (*items) memcpy(grown, *items, count * elem_size);
+    arena_block_free(&state->heap, *items);
+    *items = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+// 値の追加（text が NULL なら数値 num）
+static int data_append(basic_state_t* state, const char* text, numeric_value_t num) {
+    data_table_t* data = &state->data;
+    if (data_reserve(state, (void**)&data->items, &data->capacity, data->count, sizeof(data_item_t)) != 0) return -1;
+    data_item_t* item = &data->items[data->count];
+    item->num = num;
+    item->text = NULL;
+    if (text) {
+        item->text = arena_block_strndup(&state->heap, text, strlen(text));
+        if (!item->text) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
+            return -1;
+        }
+    }
+    data->count++;
+    return 0;
+}
+
+// DATA の値の並びを読む（append が true なら表に追加、false なら読み飛ばすだけ）
+static int parse_data_items(basic_state_t* state, parser_state_t* parser_ptr, bool append) {
     // DATA value1, value2, value3, ...
-    
     while (true) {
         token_t value_token = get_next_token(state, parser_ptr);
-        
-        char* data_value = NULL;
-        if (value_token.type == TOKEN_STRING) {
-            data_value = value_token.value.string;
+        // 符号付きの数値
+        double sign = 1.0;
+        if (value_token.type == TOKEN_OPERATOR &&
+            (value_token.value.operator == '-' || value_token.value.operator == '+')) {
+            sign = (value_token.value.operator == '-') ? -1.0 : 1.0;
+            value_token = get_next_token(state, parser_ptr);
+            if (value_token.type != TOKEN_NUMBER) {
+                set_error(state, ERR_SYNTAX, "Number expected in DATA");
+                return -1;
+            }
+        }
+        if (value_token.type == TOKEN_STRING || value_token.type == TOKEN_VARIABLE) {
+            if (append && data_append(state, value_token.value.string, double_to_numeric(0.0)) != 0) return -1;
         } else if (value_token.type == TOKEN_NUMBER) {
-            data_value = number_to_string(value_token.value.number);
-        } else if (value_token.type == TOKEN_VARIABLE) {
-            data_value = value_token.value.string;
+            // 数値は解析済みの値のまま持つ
+            numeric_value_t num = double_to_numeric(sign * numeric_to_double(value_token.value.number));
+            if (append && data_append(state, NULL, num) != 0) return -1;
         } else {
-            break; // DATA文終了
+            parser_rewind(parser_ptr, value_token.position);
+            return 0; // DATA文終了
         }
-        
-        // データエントリを作成
-        data_entry_t* entry = (data_entry_t*)malloc(sizeof(data_entry_t));
-        if (!entry) {
-            set_error(state, ERR_OUT_OF_MEMORY, NULL);
-            if (data_value) free(data_value);
-            return -1;
+
+        uint16_t save = parser_ptr->position;
+        token_t next_token = get_next_token(state, parser_ptr);
+        if (next_token.type != TOKEN_DELIMITER || next_token.value.operator != ',') {
+            parser_rewind(parser_ptr, save); // 区切りの ':' は呼び出し側で読む
+            return 0; // DATA文終了
         }
-        
-        entry->value = data_value;
-        entry->next = NULL;
-        
-        // データリストに追加
-        if (!g_data_state.data_list) {
-            g_data_state.data_list = entry;
-            g_data_state.current_data = entry;
-        } else {
-            data_entry_t* last = g_data_state.data_list;
-            while (last->next) {
-                last = last->next;
-            }
-            last->next = entry;
+    }
+}
+
+// DATA FILE "名前" の形なら名前を読んで true、そうでなければ位置を戻して false
+static bool parse_data_file_name(basic_state_t* state, parser_state_t* parser_ptr, const char** path) {
+    uint16_t save = parser_ptr->position;
+    token_t token = get_next_token(state, parser_ptr);
+    if (token.type == TOKEN_VARIABLE && strcmp(token.value.string, "FILE") == 0) {
+        token_t name = get_next_token(state, parser_ptr);
+        if (name.type == TOKEN_STRING) {
+            *path = name.value.string;
+            return true;
         }
-        
-        // 次のトークンをチェック
-        token_t next_token = get_next_token(state, parser_ptr);
-        if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') {
-            continue; // 次のデータへ
-        } else {
-            break; // DATA文終了
+    }
+    parser_rewind(parser_ptr, save);
+    return false;
+}
+
+// プログラム全体の DATA 文を走査して表を作り直す
+int scan_program_data(basic_state_t* state) {
+    data_table_t* data = &state->data;
+    for (size_t i = 0; i < data->count; i++) arena_block_free(&state->heap, data->items[i].text);
+    data->count = 0;
+    data->line_count = 0;
+    data->position = 0;
+
+    for (const program_line_t* line = state->program_start; line; line = line->next) {
+        parser_state_t parser = {line->text, 0, line->length, line->length ? line->text[0] : '\0', line};
+        bool recorded = false;
+        while (true) {
+            token_t token = get_next_token(state, &parser);
+            if (has_error(state)) {
+                // 解析できない行は実行時にエラーになるので、ここでは読み飛ばす
+                if (state->error_code == ERR_OUT_OF_MEMORY) return -1;
+                clear_error(state);
+                break;
+            }
+            if (token.type == TOKEN_EOL || token.type == TOKEN_EOF) break;
+            if (token.type != TOKEN_KEYWORD) continue;
+            if (token.value.keyword_id == 0x8E) break; // REM 以降は注釈
+            if (token.value.keyword_id != 0x83) continue;
+            const char* path;
+            if (parse_data_file_name(state, &parser, &path)) continue; // 実行時に開く
+
+            if (!recorded) {
+                if (data_reserve(state, (void**)&data->lines, &data->line_capacity, data->line_count,
+                                 sizeof(data_line_t)) != 0) {
+                    return -1;
+                }
+                data->lines[data->line_count].line_number = line->line_number;
+                data->lines[data->line_count].start = data->count;
+                data->line_count++;
+                recorded = true;
+            }
+            if (parse_data_items(state, &parser, true) != 0) return -1;
         }
     }
-    
+    data->scanned = true;
     return 0;
 }
 
+// 次の DATA の値（DATA FILE を開いていればそのフィールド、なければ OUT OF DATA）
+const data_item_t* read_data_item(basic_state_t* state) {
+    if (state->data_file.active) return read_data_file_field(state);
+    data_table_t* data = &state->data;
+    if (!data->scanned && scan_program_data(state) != 0) return NULL;
+    if (data->position >= data->count) {
+        set_error(state, ERR_OUT_OF_DATA, NULL);
+        return NULL;
+    }
+    return &data->items[data->position++];
+}
+
+// 値を数値として読む（文字列の値は数値に変換）
+numeric_value_t data_item_number(const data_item_t* item) {
+    return item->text ? string_to_number(item->text) : item->num;
+}
+
+// 値を文字列として読む（数値の値は一時領域に書式化、失敗時は NULL）
+const char* data_item_text(basic_state_t* state, const data_item_t* item) {
+    if (item->text) return item->text;
+    char text[NUMBER_FORMAT_SIZE];
+    size_t length = format_number(item->num, text);
+    return scratch_string(state, text, length);
+}
+
+// DATA文の実装 - 値は RUN 時に表へ登録済みなので読み飛ばすだけ
+// DATA FILE "名前" はここで CSV ファイルを開き、以後の READ の読み出し元にする
+int cmd_data(basic_state_t* state, parser_state_t* parser_ptr) {
+    const char* path;
+    if (parse_data_file_name(state, parser_ptr, &path)) return open_data_file(state, path);
+    return parse_data_items(state, parser_ptr, false);
+}
+
 // READ文の実装
 int cmd_read(basic_state_t* state, parser_state_t* parser_ptr) {
-    // READ var1, var2, var3, ...
+    // READ var1, A(I), var3$, ...
     
     while (true) {
         token_t var_token = get_next_token(state, parser_ptr);
@@ -325,78 +891,90 @@ int cmd_read(basic_state_t* state, parser_state_t* parser_ptr) {
             set_error(state, ERR_SYNTAX, "Variable expected in READ");
             return -1;
         }
-        
-        // データの取得
-        if (!g_data_state.current_data) {
-            set_error(state, ERR_OUT_OF_DATA, NULL);
-            free(var_token.value.string);
-            return -1;
-        }
-        
-        // 変数の作成または取得
         bool is_string = strchr(var_token.value.string, '$') != NULL;
-        variable_type_t var_type = is_string ? VAR_STRING : VAR_NUMERIC;
         
-        variable_t* var = create_variable(state, var_token.value.string, var_type);
-        if (!var) {
-            free(var_token.value.string);
-            return -1;
+        // 配列要素の添字
+        size_t indices[MAX_ARRAY_DIMENSIONS];
+        uint8_t index_count = 0;
+        uint16_t save = parser_ptr->position;
+        token_t paren = get_next_token(state, parser_ptr);
+        if (paren.type == TOKEN_DELIMITER && paren.value.operator == '(') {
+            if (parse_array_subscripts(state, parser_ptr, indices, &index_count) != 0) return -1;
+        } else {
+            parser_rewind(parser_ptr, save);
         }
         
-        // データの代入
-        if (is_string) {
-            if (var->value.str.data) {
-                free(var->value.str.data);
+        // データの取得
+        const data_item_t* item = read_data_item(state);
+        if (!item) return -1;
+        const char* text = NULL;
+        if (is_string && !(text = data_item_text(state, item))) return -1;
+        
+        if (index_count > 0) {
+            eval_result_t value = {0};
+            if (is_string) {
+                value.type = 1;
+                value.value.str.data = (char*)text;
+                value.value.str.length = (uint32_t)strlen(text);
+            } else {
+                value.type = 0;
+                value.value.num = data_item_number(item);
             }
-            var->value.str.data = safe_string_dup(g_data_state.current_data->value, MAX_STRING_LENGTH);
-            var->value.str.length = var->value.str.data ? strlen(var->value.str.data) : 0;
+            variable_t* array_var = find_variable(state, var_token.value.string);
+            if (assign_array_element(state, array_var, indices, index_count, value) != 0) return -1;
         } else {
-            var->value.num = string_to_number(g_data_state.current_data->value);
+            variable_type_t var_type = is_string ? VAR_STRING : VAR_NUMERIC;
+            variable_t* var = create_variable(state, var_token.value.string, var_type);
+            if (!var) return -1;
+            if (is_string) {
+                char* data = heap_string(state, text, strlen(text));
+                if (!data) return -1;
+                variable_set_string(state, var, data);
+            } else {
+                var->value.num = data_item_number(item);
+            }
         }
         
-        // 次のデータに進む
-        g_data_state.current_data = g_data_state.current_data->next;
-        
-        free(var_token.value.string);
-        
         // 次の変数があるかチェック
+        save = parser_ptr->position;
         token_t next_token = get_next_token(state, parser_ptr);
         if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') {
             continue; // 次の変数へ
-        } else {
-            break; // READ文終了
         }
+        parser_rewind(parser_ptr, save); // 区切りの ':' は呼び出し側で読む
+        return 0;
     }
-    
-    return 0;
 }
 
-// RESTORE文の実装
+// RESTORE文の実装 - RESTORE [行番号]
 int cmd_restore(basic_state_t* state, parser_state_t* parser_ptr) {
-    (void)parser_ptr; // 未使用パラメータ
-    (void)state;      // 未使用パラメータ
+    data_table_t* data = &state->data;
+    if (!data->scanned && scan_program_data(state) != 0) return -1;
     
-    // データポインターをリセット
-    g_data_state.current_data = g_data_state.data_list;
+    uint16_t save = parser_ptr->position;
+    token_t token = get_next_token(state, parser_ptr);
+    if (token.type != TOKEN_NUMBER) {
+        // データポインターを先頭に戻す
+        parser_rewind(parser_ptr, save);
+        if (state->data_file.active) rewind_data_file(state);
+        else data->position = 0;
+        return 0;
+    }
     
-    return 0;
-}
-
-// データ状態のクリーンアップ
-void cleanup_data_state(void) {
-    data_entry_t* current = g_data_state.data_list;
-    while (current) {
-        data_entry_t* next = current->next;
-        if (current->value) {
-            free(current->value);
-        }
-        free(current);
-        current = next;
+    double target = numeric_to_double(token.value.number);
+    if (!(target >= 0 && target <= 65535) || !find_line(state, (uint16_t)target)) {
+        set_error(state, ERR_UNDEF_STATEMENT, NULL);
+        return -1;
     }
+    close_data_file(state); // プログラムの DATA に戻る
     
-    g_data_state.data_list = NULL;
-    g_data_state.current_data = NULL;
+    // 指定行以降で最初の DATA 行の先頭へ
+    size_t lo = 0, hi = data->line_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (data->lines[mid].line_number < (uint16_t)target) lo = mid + 1;
+        else hi = mid;
+    }
+    data->position = (lo < data->line_count) ? data->lines[lo].start : data->count;
+    return 0;
 }
-
-
-
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 // バージョン情報
 #define BASIC_VERSION_MAJOR 1
@@ -16,10 +17,24 @@
 // 設定定数
 #define MAX_LINE_LENGTH 72
 #define MAX_VARIABLES 256
+#define VAR_TABLE_SIZE (26 * 37 * 2)    // 変数表のスロット数（1文字目 × 2文字目 × 文字列フラグ）
 #define MAX_PROGRAM_LINES 1000
 #define MAX_STRING_LENGTH 255
+#define MAX_LONG_STRING_LENGTH (16UL * 1024 * 1024) // ロングストリングモード時
 #define MAX_ARRAY_DIMENSIONS 8
 #define STACK_SIZE 512
+#define SCRATCH_CHUNK_SIZE 4096     // 一時領域アリーナのチャンクサイズ
+#define HEAP_CHUNK_SIZE 65536       // 実行時アリーナのチャンクサイズ
+#define ARENA_SIZE_CLASSES 9        // 再利用ブロックのサイズクラス数（16〜4096バイト）
+#define ARENA_ARRAY_ALIGN 64        // 配列領域の境界（キャッシュライン）
+#define ARRAY_INDEX_INVALID ((size_t)-1) // 配列の要素数・添字の計算失敗
+#define SPARSE_AUTO_ELEMENTS (16UL * 1024 * 1024) // DIM でこれを超える要素数なら疎な配列にする
+#define NUMBER_FORMAT_SIZE 32       // format_number の出力領域の大きさ
+#define OUTPUT_BUFFER_SIZE 65536    // 出力バッファの大きさ
+#define OUTPUT_RING_SIZE (1UL << 20) // 非同期出力のリングバッファの大きさ（2のべき乗）
+#define INPUT_BUFFER_SIZE 65536     // 標準入力の読み込み領域の初期の大きさ
+#define MAX_FILE_CHANNELS 15        // OPEN できるファイル番号の上限（#1〜#15）
+#define VIRTUAL_MEMORY_SIZE 65536   // PEEK/POKE の仮想メモリの大きさ
 
 // エラーコード定義
 typedef enum {
@@ -38,7 +53,12 @@ typedef enum {
     ERR_SUBSCRIPT_OUT_OF_RANGE = 12,
     ERR_REDIMENSIONED_ARRAY = 13,
     ERR_RETURN_WITHOUT_GOSUB = 14,
-    ERR_NEXT_WITHOUT_FOR = 15
+    ERR_NEXT_WITHOUT_FOR = 15,
+    ERR_FILE_IO = 16,
+    ERR_INPUT_PAST_END = 17,
+    ERR_BAD_FILE_NUMBER = 18,
+    ERR_BAD_FILE_MODE = 19,
+    ERR_FILE_ALREADY_OPEN = 20
 } error_code_t;
 
 // 変数型定義
@@ -46,7 +66,9 @@ typedef enum {
     VAR_NUMERIC,
     VAR_STRING,
     VAR_ARRAY_NUMERIC,
-    VAR_ARRAY_STRING
+    VAR_ARRAY_STRING,
+    VAR_MAP_NUMERIC,        // 連想配列（DIM M AS MAP）
+    VAR_MAP_STRING
 } variable_type_t;
 
 // 浮動小数点数表現
@@ -61,6 +83,67 @@ typedef union {
     double modern;          // 現代的な形式
 } numeric_value_t;
 
+// ロープ（ロングストリングモードの文字列表現、rope.c）
+typedef struct rope_node rope_node_t;
+typedef struct rope rope_t;
+
+// 配列の記憶方式（array_storage.c）
+typedef enum {
+    ARRAY_STORAGE_ARENA = 0,    // 実行時アリーナ上の連続領域
+    ARRAY_STORAGE_FILE,         // ファイルをマップした領域（DIM ... AS FILE）
+    ARRAY_STORAGE_SPARSE        // 代入された要素だけを持つ表（DIM ... AS SPARSE）
+} array_storage_t;
+
+// 文字列配列の格納形式（arrays_and_data.c）
+// 要素はオフセット表に持ち、文字データは配列ごとの共有領域に詰めて置く
+typedef struct {
+    uint32_t offset;        // 文字領域内の位置（0 = 共有の空文字列）
+    uint32_t length;
+} string_slot_t;
+
+typedef struct {
+    char* data;             // NUL終端の文字列を連続して格納（先頭1バイトは空文字列）
+    size_t used;
+    size_t capacity;
+    size_t garbage;         // 上書きで不要になったバイト数
+} string_heap_t;
+
+// 疎な配列の格納形式（array_storage.c）
+// 代入された要素だけを、線形添字をキーとするオープンアドレス法の表に持つ
+typedef struct {
+    size_t key;             // 線形添字 + 1（0 = 空き）
+    union {
+        numeric_value_t num;
+        string_slot_t str;
+    } value;
+} sparse_entry_t;
+
+typedef struct {
+    sparse_entry_t* entries;
+    size_t capacity;        // 2の冪
+    size_t count;
+} sparse_table_t;
+
+// 連想配列の格納形式（map_functions.c）
+// 要素は追加順に entries に並べ、キーの検索はオープンアドレス法の索引表で行う
+typedef struct {
+    char* key;              // 実行時アリーナのブロック（NUL終端）
+    uint32_t key_length;
+    uint64_t hash;
+    union {
+        numeric_value_t num;
+        char* str;          // 実行時アリーナのブロック（NULL = 空文字列）
+    } value;
+} map_entry_t;
+
+typedef struct {
+    map_entry_t* entries;   // 追加順
+    size_t count;
+    size_t entry_capacity;
+    uint32_t* index;        // entries の位置 + 1（0 = 空き）
+    size_t index_capacity;  // 2の冪
+} map_table_t;
+
 // 変数構造体
 typedef struct variable {
     char name[3];           // 変数名 (最大2文字 + NULL)
@@ -69,14 +152,20 @@ typedef struct variable {
         numeric_value_t num;
         struct {
             char* data;
-            uint16_t length;
+            uint32_t length;
+            rope_t* rope;   // ロングストリングモードで追記された文字列（data は NULL）
         } str;
         struct {
-            void* data;
-            uint16_t* dimensions;
+            void* data;             // ARENA_ARRAY_ALIGN 境界、ゼロ初期化（疎な配列では sparse_table_t）
+            size_t* dimensions;     // 各次元の上限（添字は 0〜上限）
+            size_t* strides;        // 各次元の添字1つあたりの要素数（DIM時に計算）
             uint8_t dim_count;
-            uint16_t total_elements;
+            size_t total_elements;
+            size_t capacity;        // 確保済みの要素数（APPEND による拡張の余裕を含む）
+            string_heap_t* strings; // 文字列配列の文字領域（数値配列は NULL）
+            array_storage_t storage;
         } array;
+        map_table_t* map;
     } value;
     struct variable* next;
 } variable_t;
@@ -86,6 +175,7 @@ typedef struct program_line {
     uint16_t line_number;
     uint16_t length;
     char* text;
+    char* literals;         // 文字列定数プール（NULL = 定数なし）
     struct program_line* next;
 } program_line_t;
 
@@ -106,17 +196,122 @@ typedef struct gosub_stack_entry {
     struct gosub_stack_entry* next;
 } gosub_stack_entry_t;
 
+// DATA文の値の表（RUN時にプログラム全体を走査して作る）
+typedef struct {
+    uint16_t line_number;
+    size_t start;           // その行の最初の値の位置
+} data_line_t;
+
+typedef struct {
+    char* text;             // 文字列の値（NULL なら数値）
+    numeric_value_t num;    // 数値の値（解析済み）
+} data_item_t;
+
+typedef struct {
+    data_item_t* items;     // 値（プログラム順）
+    size_t count;
+    size_t capacity;
+    data_line_t* lines;     // DATA文を含む行（行番号順）
+    size_t line_count;
+    size_t line_capacity;
+    size_t position;        // READ位置
+    bool scanned;           // 走査済み（プログラムの変更で無効になる）
+} data_table_t;
+
+// DATA FILE で開いた CSV ファイル（開いている間は READ がここから読む）
+typedef struct {
+    const char* text;       // ファイルにマップした内容
+    size_t length;
+    size_t cursor;          // 次のフィールドの位置
+    bool after_comma;       // 直前のフィールドが , で終わった（次は同じレコードの続き）
+    bool active;
+    data_item_t item;       // 最後に読んだフィールド（文字列は一時領域）
+} data_file_t;
+
+// ファイルにマップした配列領域（CLEAR/RUN/NEWで解除）
+typedef struct mapped_region {
+    void* addr;
+    size_t length;
+    struct mapped_region* next;
+} mapped_region_t;
+
+// 出力バッファ（output.c）
+typedef enum {
+    OUTPUT_FLUSH_LINE,      // 改行ごとに書き出す（端末向け）
+    OUTPUT_FLUSH_BLOCK      // 満杯・入力待ち・END/STOP でだけ書き出す
+} output_flush_t;
+
+typedef struct {
+    int fd;
+    output_flush_t flush;
+    size_t used;
+    bool failed;            // 書き込みに失敗した（残りは捨てている）
+    char buffer[OUTPUT_BUFFER_SIZE];
+
+    // 非同期書き出し（ring が NULL でなければ書き出しスレッドが ring から fd へ書く）
+    // head は解釈側、tail はスレッドだけが進める通算バイト数
+    char* ring;
+    size_t head;
+    size_t tail;
+    bool stop;
+    bool writer_waiting;    // スレッドが空の ring を待っている
+    bool producer_waiting;  // 解釈側が ring の空きか書き出し完了を待っている
+    pthread_t thread;
+    pthread_mutex_t lock;   // 待ち合わせ専用（ring の読み書きには使わない）
+    pthread_cond_t ready;
+    pthread_cond_t drained;
+} output_t;
+
+// 行単位の入力（input.c）
+typedef struct {
+    int fd;
+    bool interactive;       // 端末から読む（INPUT のプロンプトを表示する）
+    bool mapped;            // buffer はファイルのマップ（capacity はその長さ）
+    char* buffer;           // 読み込み領域（長い行が収まらなければ広げる）
+    size_t capacity;
+    size_t start;           // 未処理の先頭
+    size_t end;             // 読み込み済みの末尾
+    bool eof;               // これ以上読めない
+} input_reader_t;
+
+// ファイルチャネル（file_channels.c）
+typedef enum {
+    FILE_MODE_INPUT,
+    FILE_MODE_OUTPUT,
+    FILE_MODE_APPEND
+} file_mode_t;
+
+typedef struct {
+    file_mode_t mode;
+    int fd;
+    input_reader_t in;      // INPUT で開いたとき
+    output_t* out;          // OUTPUT/APPEND で開いたとき（バッファが大きいので別に確保）
+    uint8_t column;         // PRINT# の桁位置（, と TAB 用）
+} file_channel_t;
+
+// アリーナ（arena.c）
+typedef struct arena_chunk arena_chunk_t;
+typedef struct arena_large arena_large_t;
+typedef struct {
+    arena_chunk_t* head;            // 現在のチャンク
+    size_t chunk_size;              // 標準チャンクサイズ
+    void* free_blocks[ARENA_SIZE_CLASSES]; // 解放済みブロック（サイズクラス別）
+    arena_large_t* large;           // 大きなブロックのリスト
+} basic_arena_t;
+
 // システム状態構造体
 typedef struct {
     // メモリポインター
     program_line_t* program_start;  // プログラム開始
-    variable_t* variables;          // 変数リスト
+    variable_t* variables;          // 変数リスト（列挙用）
+    variable_t* var_table[VAR_TABLE_SIZE]; // 変数名による直接索引表
     
     // 実行状態
     program_line_t* current_line;   // 現在実行中の行
     uint16_t current_position;      // 行内の位置
     bool running;                   // 実行中フラグ
     bool immediate_mode;            // 即座実行モード
+    bool long_strings;              // ロングストリングモード（文字列長上限を拡張）
     
     // 制御フラグ
     uint8_t valtyp;         // 値型 (0=数値, 1=文字列)
@@ -128,12 +323,21 @@ typedef struct {
     uint8_t trmpos;         // 端末位置
     uint8_t linwid;         // 行幅
     uint16_t linnum;        // 現在行番号
-    char input_buffer[MAX_LINE_LENGTH + 1];
+    input_reader_t input;   // 標準入力
+    output_t output;        // 標準出力のバッファ
+    file_channel_t* files[MAX_FILE_CHANNELS + 1]; // OPEN したファイル（0 は使わない）
     
     // スタック
     for_stack_entry_t* for_stack;
     gosub_stack_entry_t* gosub_stack;
     
+    // DATA文
+    data_table_t data;
+    data_file_t data_file;
+    
+    // ファイルにマップした配列
+    mapped_region_t* mapped_regions;
+    
     // エラー処理
     error_code_t error_code;
     char error_msg[128];
@@ -145,6 +349,12 @@ typedef struct {
     
     // 乱数シード
     uint32_t rnd_seed;
+    
+    // 式評価の一時領域（文ごとにリセット）
+    basic_arena_t scratch;
+    
+    // 実行時領域（変数・配列・スタック・DATA、CLEAR/RUN/NEWで一括解放）
+    basic_arena_t heap;
 } basic_state_t;
 
 // トークン定義
@@ -177,7 +387,7 @@ typedef struct {
         numeric_value_t num;
         struct {
             char* data;
-            uint16_t length;
+            uint32_t length;
         } str;
     } value;
 } eval_result_t;
@@ -188,8 +398,36 @@ typedef struct {
     uint16_t position;
     uint16_t length;
     char current_char; // parser.c uses a cached current character
+    const program_line_t* line; // program line being parsed (NULL in immediate mode)
 } parser_state_t;
 
+// キーワードID（parser.c の keywords[] の値。KW_MAT 以降は元のBASICにない拡張キーワード）
+#define KW_FOR     0x81
+#define KW_INPUT   0x84
+#define KW_READ    0x86
+#define KW_PRINT   0x97
+#define KW_MAT     0xC5
+#define KW_SUM     0xC6
+#define KW_MIN     0xC7
+#define KW_MAX     0xC8
+#define KW_MEAN    0xC9
+#define KW_DOT     0xCA
+#define KW_COUNT   0xCB
+#define KW_BSEARCH 0xCC
+#define KW_SORT    0xCD
+#define KW_REDIM   0xCE
+#define KW_APPEND  0xCF
+#define KW_HASKEY  0xD0
+#define KW_KEYS    0xD1
+#define KW_KEY     0xD2   // KEY$
+#define KW_LINE    0xD3
+#define KW_EOF     0xD4
+#define KW_OPEN    0xD5
+#define KW_CLOSE   0xD6
+#define KW_LOF     0xD7
+#define KW_BSAVE   0xD8
+#define KW_BLOAD   0xD9
+
 // 公開API関数
 int basic_init(basic_state_t* state);
 void basic_cleanup(basic_state_t* state);
@@ -198,6 +436,7 @@ int basic_run_program(basic_state_t* state);
 int basic_execute_line(basic_state_t* state, const char* line);
 void basic_list_program(basic_state_t* state);
 void basic_new_program(basic_state_t* state);
+void basic_clear_run_state(basic_state_t* state);
 
 // エラー処理
 void set_error(basic_state_t* state, error_code_t code, const char* msg);
@@ -205,11 +444,37 @@ void clear_error(basic_state_t* state);
 bool has_error(basic_state_t* state);
 void print_error(basic_state_t* state);
 
+// 出力（output.c）
+void output_init(output_t* out, int fd);
+void output_put(output_t* out, const char* data, size_t length);
+void output_put_spaces(output_t* out, int count);
+void output_drain(output_t* out);
+int output_start_writer(basic_state_t* state);
+void output_stop_writer(basic_state_t* state);
+void output_flush(basic_state_t* state);
+void output_write(basic_state_t* state, const char* data, size_t length);
+void output_text(basic_state_t* state, const char* text);
+void output_char(basic_state_t* state, char c);
+void output_spaces(basic_state_t* state, int count);
+void output_printf(basic_state_t* state, const char* format, ...);
+
+// 入力（input.c）
+void input_init(input_reader_t* in, int fd);
+int input_map(input_reader_t* in, int fd, size_t length);
+void input_release(input_reader_t* in);
+char* input_read_line(basic_state_t* state, input_reader_t* in, size_t* length);
+int input_read_char(basic_state_t* state, input_reader_t* in);
+bool input_at_eof(basic_state_t* state, input_reader_t* in);
+
 // ユーティリティ関数
-char* safe_string_dup(const char* src, uint16_t max_len);
-char* number_to_string(numeric_value_t n);
+char* safe_string_dup(const char* src, size_t max_len);
+char* scratch_string(basic_state_t* state, const char* src, size_t len);
+char* heap_string(basic_state_t* state, const char* src, size_t len);
+size_t string_limit(basic_state_t* state);
+size_t format_number(numeric_value_t num, char* buf);
+double parse_decimal(const char* text, const char** end);
+double parse_decimal_literal(const char* text, const char** end);
 numeric_value_t string_to_number(const char* str);
-void cleanup_data_state(void);
 int count_variables(basic_state_t* state);
 numeric_value_t double_to_numeric(double d);
 double numeric_to_double(numeric_value_t n);
@@ -231,8 +496,24 @@ int cmd_dim(basic_state_t* state, parser_state_t* parser);
 int cmd_data(basic_state_t* state, parser_state_t* parser);
 int cmd_read(basic_state_t* state, parser_state_t* parser);
 int cmd_restore(basic_state_t* state, parser_state_t* parser);
+int scan_program_data(basic_state_t* state);
+const data_item_t* read_data_item(basic_state_t* state);
+numeric_value_t data_item_number(const data_item_t* item);
+const char* data_item_text(basic_state_t* state, const data_item_t* item);
+int open_data_file(basic_state_t* state, const char* path);
+void close_data_file(basic_state_t* state);
+void rewind_data_file(basic_state_t* state);
+const data_item_t* read_data_file_field(basic_state_t* state);
 int cmd_input(basic_state_t* state, parser_state_t* parser);
 int cmd_input_ex(basic_state_t* state, parser_state_t* parser);
+int cmd_line_input(basic_state_t* state, parser_state_t* parser);
+int cmd_open(basic_state_t* state, parser_state_t* parser);
+int cmd_close(basic_state_t* state, parser_state_t* parser);
+file_channel_t* parse_file_channel(basic_state_t* state, parser_state_t* parser, bool writing);
+int close_all_files(basic_state_t* state);
+int cmd_bsave(basic_state_t* state, parser_state_t* parser);
+int cmd_bload(basic_state_t* state, parser_state_t* parser);
+uint8_t* virtual_memory_base(void);
 int cmd_clear(basic_state_t* state, parser_state_t* parser);
 int cmd_stop(basic_state_t* state, parser_state_t* parser);
 int cmd_end(basic_state_t* state, parser_state_t* parser);
@@ -244,19 +525,84 @@ int cmd_null(basic_state_t* state, parser_state_t* parser);
 int cmd_on_goto(basic_state_t* state, parser_state_t* parser);
 int cmd_cont(basic_state_t* state, parser_state_t* parser);
 int cmd_rem(basic_state_t* state, parser_state_t* parser);
+int cmd_mat(basic_state_t* state, parser_state_t* parser);
+int cmd_sort(basic_state_t* state, parser_state_t* parser);
+int cmd_redim(basic_state_t* state, parser_state_t* parser);
+int cmd_append(basic_state_t* state, parser_state_t* parser);
 
 // パーサー関数
 token_t get_next_token(basic_state_t* state, parser_state_t* parser);
+void parser_rewind(parser_state_t* parser, uint16_t position);
 eval_result_t evaluate_expression(basic_state_t* state, parser_state_t* parser);
+eval_result_t evaluate_expression_with_precedence(basic_state_t* state, parser_state_t* parser, uint8_t min_precedence);
 eval_result_t evaluate_variable(basic_state_t* state, parser_state_t* parser, const char* var_name);
 eval_result_t evaluate_function(basic_state_t* state, parser_state_t* parser, uint8_t function_id);
+eval_result_t func_array_aggregate(basic_state_t* state, parser_state_t* parser, uint8_t function_id);
+eval_result_t func_bsearch(basic_state_t* state, parser_state_t* parser);
+eval_result_t func_map(basic_state_t* state, parser_state_t* parser, uint8_t function_id);
+eval_result_t func_file(basic_state_t* state, parser_state_t* parser, uint8_t function_id);
 eval_result_t perform_operation(basic_state_t* state, eval_result_t left, char operator, eval_result_t right);
 
 // 変数・配列関数
 variable_t* find_variable(basic_state_t* state, const char* name);
 variable_t* create_variable(basic_state_t* state, const char* name, variable_type_t type);
 program_line_t* find_line(basic_state_t* state, uint16_t line_number);
-eval_result_t access_array_element(basic_state_t* state, const char* var_name, uint16_t* indices, uint8_t index_count);
-int assign_array_element(basic_state_t* state, const char* var_name, uint16_t* indices, uint8_t index_count, eval_result_t value);
+size_t calculate_array_size(const size_t* dimensions, uint8_t dim_count);
+variable_t* create_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count);
+variable_t* install_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count,
+                          void* data, array_storage_t storage);
+variable_t* create_file_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count,
+                              const char* path);
+void unmap_file_arrays(basic_state_t* state);
+variable_t* create_sparse_array(basic_state_t* state, const char* name, const size_t* dimensions, uint8_t dim_count);
+sparse_entry_t* sparse_find(const variable_t* var, size_t index);
+sparse_entry_t* sparse_insert(basic_state_t* state, variable_t* var, size_t index);
+int sparse_redimension(basic_state_t* state, variable_t* var, const size_t* dimensions, const size_t* strides,
+                       bool preserve);
+size_t remap_array_index(const variable_t* var, size_t index, const size_t* dimensions, const size_t* strides);
+variable_t* resolve_array(basic_state_t* state, token_t token, bool numeric_only);
+const char* string_array_get(const variable_t* var, size_t index, uint32_t* length);
+int string_array_set(basic_state_t* state, variable_t* var, size_t index, const char* text, size_t length);
+int parse_array_subscripts(basic_state_t* state, parser_state_t* parser, size_t* indices, uint8_t* index_count);
+eval_result_t access_array_element(basic_state_t* state, variable_t* var, const size_t* indices, uint8_t index_count);
+int assign_array_element(basic_state_t* state, variable_t* var, const size_t* indices, uint8_t index_count, eval_result_t value);
+variable_t* create_map(basic_state_t* state, const char* name);
+int parse_map_key(basic_state_t* state, parser_state_t* parser, const char** key, uint32_t* key_length);
+eval_result_t access_map_element(basic_state_t* state, variable_t* var, const char* key, uint32_t key_length);
+int assign_map_element(basic_state_t* state, variable_t* var, const char* key, uint32_t key_length, eval_result_t value);
+const char* variable_string(variable_t* var);
+void variable_set_string(basic_state_t* state, variable_t* var, char* data);
+void variable_free_string(basic_state_t* state, variable_t* var);
+
+// アリーナ関数
+void arena_init(basic_arena_t* arena, size_t chunk_size);
+void* arena_alloc(basic_arena_t* arena, size_t size);
+char* arena_strndup(basic_arena_t* arena, const char* src, size_t len);
+void* arena_block_alloc(basic_arena_t* arena, size_t size);
+void* arena_array_alloc(basic_arena_t* arena, size_t count, size_t elem_size);
+void arena_block_free(basic_arena_t* arena, void* p);
+size_t arena_block_size(const void* p);
+char* arena_block_strndup(basic_arena_t* arena, const char* src, size_t len);
+void arena_reset(basic_arena_t* arena);
+void arena_release(basic_arena_t* arena);
+
+// ベクトル演算（vector_kernels.c）
+void vec_add(double* dst, const double* a, const double* b, size_t n);
+void vec_sub(double* dst, const double* a, const double* b, size_t n);
+void vec_scale(double* dst, const double* a, double k, size_t n);
+void vec_axpy(double* dst, double k, const double* x, size_t n);
+void mat_multiply(double* dst, const double* a, const double* b, size_t m, size_t n, size_t p);
+void mat_transpose(double* dst, const double* a, size_t rows, size_t cols);
+double vec_sum(const double* a, size_t n);
+double vec_dot(const double* a, const double* b, size_t n);
+void vec_minmax(const double* a, size_t n, double* min_out, double* max_out);
+size_t vec_count_equal(const double* a, double value, size_t n);
+
+// ロープ関数
+rope_t* rope_from_string(basic_arena_t* arena, char* data);
+int rope_append(rope_t* rope, const char* data, size_t length);
+size_t rope_length(const rope_t* rope);
+const char* rope_flatten(rope_t* rope);
+void rope_free(rope_t* rope);
 
 #endif // BASIC_H
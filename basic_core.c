@@ -1,5 +1,6 @@
 #include "basic.h"
 #include <time.h>
+#include <unistd.h>
 
 // 初期化
 int basic_init(basic_state_t* state) {
@@ -12,51 +13,85 @@ int basic_init(basic_state_t* state) {
     state->linwid = MAX_LINE_LENGTH;
     state->rnd_seed = (uint32_t)time(NULL);
     state->immediate_mode = true;
+    arena_init(&state->scratch, SCRATCH_CHUNK_SIZE);
+    arena_init(&state->heap, HEAP_CHUNK_SIZE);
+    input_init(&state->input, STDIN_FILENO);
+    output_init(&state->output, STDOUT_FILENO);
     
     return 0;
 }
 
-// クリーンアップ
-void basic_cleanup(basic_state_t* state) {
-    if (!state) return;
-    
-    // プログラム行の解放
+// プログラム行1行の解放
+static void free_program_line(program_line_t* line) {
+    if (line->text) free(line->text);
+    if (line->literals) free(line->literals);
+    free(line);
+}
+
+// プログラム行の解放
+static void free_program_lines(basic_state_t* state) {
     program_line_t* line = state->program_start;
     while (line) {
         program_line_t* next = line->next;
-        if (line->text) free(line->text);
-        free(line);
+        free_program_line(line);
         line = next;
     }
+    state->program_start = NULL;
+}
+
+// 文字列定数プールの作成
+// 行テキストと同じ長さのバッファで、開始の " の位置に '"' を、その直後から
+// 内容を置き、終了の " の位置を NUL にする。評価時は複製せずに参照する
+static char* build_literal_pool(const char* text, size_t length) {
+    if (!memchr(text, '"', length)) return NULL;
     
-    // 変数の解放
-    variable_t* var = state->variables;
-    while (var) {
-        variable_t* next = var->next;
-        if (var->type == VAR_STRING && var->value.str.data) {
-            free(var->value.str.data);
-        } else if (var->type == VAR_ARRAY_NUMERIC || var->type == VAR_ARRAY_STRING) {
-            if (var->value.array.data) free(var->value.array.data);
-            if (var->value.array.dimensions) free(var->value.array.dimensions);
+    char* pool = (char*)calloc(length + 1, 1);
+    if (!pool) return NULL;
+    
+    size_t i = 0;
+    while (i < length) {
+        if (text[i] != '"') {
+            i++;
+            continue;
         }
-        free(var);
-        var = next;
+        const char* close = (const char*)memchr(text + i + 1, '"', length - i - 1);
+        if (!close) break; // 閉じられていない文字列は実行時にエラー
+        size_t end = (size_t)(close - text);
+        pool[i] = '"';
+        memcpy(pool + i + 1, text + i + 1, end - i - 1);
+        i = end + 1;
     }
+    return pool;
+}
+
+// クリーンアップ
+void basic_cleanup(basic_state_t* state) {
+    if (!state) return;
     
-    // スタックの解放
-    for_stack_entry_t* for_entry = state->for_stack;
-    while (for_entry) {
-        for_stack_entry_t* next = for_entry->next;
-        free(for_entry);
-        for_entry = next;
-    }
+    output_stop_writer(state);
+    output_flush(state);
+    free_program_lines(state);
+    basic_clear_run_state(state);
+    arena_release(&state->heap);
+    arena_release(&state->scratch);
+    input_release(&state->input);
+}
+
+// 実行時状態のクリア（CLEAR/RUN/NEW）
+// 変数・配列・スタック・DATAはすべて実行時アリーナにあるため、個別に解放せず一括で破棄する
+// ファイルにマップした配列と DATA FILE だけは先にマップを解除し、OPEN したファイルは閉じる
+void basic_clear_run_state(basic_state_t* state) {
+    if (!state) return;
     
-    gosub_stack_entry_t* gosub_entry = state->gosub_stack;
-    while (gosub_entry) {
-        gosub_stack_entry_t* next = gosub_entry->next;
-        free(gosub_entry);
-        gosub_entry = next;
-    }
+    unmap_file_arrays(state);
+    close_data_file(state);
+    close_all_files(state);
+    arena_reset(&state->heap);
+    state->variables = NULL;
+    memset(state->var_table, 0, sizeof(state->var_table));
+    state->for_stack = NULL;
+    state->gosub_stack = NULL;
+    memset(&state->data, 0, sizeof(state->data));
 }
 
 // エラー設定
@@ -115,6 +150,21 @@ void set_error(basic_state_t* state, error_code_t code, const char* msg) {
             case ERR_NEXT_WITHOUT_FOR:
                 strcpy(state->error_msg, "NEXT WITHOUT FOR ERROR");
                 break;
+            case ERR_FILE_IO:
+                strcpy(state->error_msg, "FILE I/O ERROR");
+                break;
+            case ERR_INPUT_PAST_END:
+                strcpy(state->error_msg, "INPUT PAST END ERROR");
+                break;
+            case ERR_BAD_FILE_NUMBER:
+                strcpy(state->error_msg, "BAD FILE NUMBER ERROR");
+                break;
+            case ERR_BAD_FILE_MODE:
+                strcpy(state->error_msg, "BAD FILE MODE ERROR");
+                break;
+            case ERR_FILE_ALREADY_OPEN:
+                strcpy(state->error_msg, "FILE ALREADY OPEN ERROR");
+                break;
             default:
                 strcpy(state->error_msg, "UNKNOWN ERROR");
                 break;
@@ -138,11 +188,11 @@ bool has_error(basic_state_t* state) {
 void print_error(basic_state_t* state) {
     if (!state || state->error_code == ERR_NONE) return;
     
-    printf("?%s", state->error_msg);
+    output_printf(state, "?%s", state->error_msg);
     if (state->current_line && state->current_line->line_number > 0) {
-        printf(" IN %d", state->current_line->line_number);
+        output_printf(state, " IN %d", state->current_line->line_number);
     }
-    printf("\n");
+    output_char(state, '\n');
 }
 
 // 数値変換ユーティリティ
@@ -166,47 +216,96 @@ static void build_name_signature(const char* name, char sig[3]) {
     }
 }
 
+// 変数表のスロット番号
+// 1文字目は英字(26)、2文字目はなし/英字/数字(37)、末尾 $ の有無(2) で一意に決まる
+static int variable_slot(const char sig[3]) {
+    unsigned char c1 = (unsigned char)sig[0];
+    unsigned char c2 = (unsigned char)sig[1];
+    if (c1 < 'A' || c1 > 'Z') return -1;
+    int second;
+    if (c2 == 0) second = 0;
+    else if (c2 >= 'A' && c2 <= 'Z') second = 1 + (c2 - 'A');
+    else second = 27 + (c2 - '0');
+    return (((c1 - 'A') * 37) + second) * 2 + (sig[2] == '$' ? 1 : 0);
+}
+
 variable_t* find_variable(basic_state_t* state, const char* name) {
     if (!state || !name) return NULL;
     char key[3];
     build_name_signature(name, key);
 
-    variable_t* var = state->variables;
-    while (var) {
-        if (memcmp(var->name, key, 3) == 0) {
-            return var;
-        }
-        var = var->next;
-    }
-    return NULL;
+    int slot = variable_slot(key);
+    return slot < 0 ? NULL : state->var_table[slot];
 }
 
 // 変数作成
 variable_t* create_variable(basic_state_t* state, const char* name, variable_type_t type) {
     if (!state || !name) return NULL;
     
+    char key[3];
+    build_name_signature(name, key);
+    int slot = variable_slot(key);
+    if (slot < 0) {
+        set_error(state, ERR_SYNTAX, "Invalid variable name");
+        return NULL;
+    }
+    
     // 既存変数チェック
-    variable_t* existing = find_variable(state, name);
-    if (existing) return existing;
+    // 同じ名前の配列・連想配列に単純変数として代入すると値の共用体を壊すので TYPE MISMATCH
+    variable_t* existing = state->var_table[slot];
+    if (existing) {
+        bool scalar = (type == VAR_NUMERIC || type == VAR_STRING);
+        if (scalar && existing->type != type) {
+            set_error(state, ERR_TYPE_MISMATCH, NULL);
+            return NULL;
+        }
+        return existing;
+    }
     
     // 新規変数作成
-    variable_t* var = (variable_t*)malloc(sizeof(variable_t));
+    variable_t* var = (variable_t*)arena_alloc(&state->heap, sizeof(variable_t));
     if (!var) {
         set_error(state, ERR_OUT_OF_MEMORY, NULL);
         return NULL;
     }
     
     memset(var, 0, sizeof(variable_t));
-    build_name_signature(name, var->name);
+    memcpy(var->name, key, sizeof(var->name));
     var->type = type;
     
-    // リストに追加
+    // 索引表とリストに追加
+    state->var_table[slot] = var;
     var->next = state->variables;
     state->variables = var;
     
     return var;
 }
 
+// 文字列変数の値を取得（ロープは平坦化する）
+const char* variable_string(variable_t* var) {
+    if (!var) return NULL;
+    if (var->value.str.rope) return rope_flatten(var->value.str.rope);
+    return var->value.str.data;
+}
+
+// 文字列変数への代入（heap_string() で確保した data の所有権を受け取る）
+void variable_set_string(basic_state_t* state, variable_t* var, char* data) {
+    if (!var) return;
+    variable_free_string(state, var);
+    var->value.str.data = data;
+    var->value.str.length = data ? (uint32_t)strlen(data) : 0;
+}
+
+// 文字列変数の値を解放
+void variable_free_string(basic_state_t* state, variable_t* var) {
+    if (!var) return;
+    if (var->value.str.data) arena_block_free(&state->heap, var->value.str.data);
+    if (var->value.str.rope) rope_free(var->value.str.rope);
+    var->value.str.data = NULL;
+    var->value.str.rope = NULL;
+    var->value.str.length = 0;
+}
+
 // プログラム行検索
 program_line_t* find_line(basic_state_t* state, uint16_t line_number) {
     if (!state) return NULL;
@@ -228,6 +327,9 @@ program_line_t* find_line(basic_state_t* state, uint16_t line_number) {
 int add_program_line(basic_state_t* state, uint16_t line_number, const char* text) {
     if (!state || !text) return -1;
     
+    // DATAの表は次の READ/RESTORE で作り直す
+    state->data.scanned = false;
+    
     // 既存行の削除（行番号のみの場合）
     if (strlen(text) == 0) {
         program_line_t* prev = NULL;
@@ -240,8 +342,7 @@ int add_program_line(basic_state_t* state, uint16_t line_number, const char* tex
                 } else {
                     state->program_start = line->next;
                 }
-                if (line->text) free(line->text);
-                free(line);
+                free_program_line(line);
                 return 0;
             }
             prev = line;
@@ -266,6 +367,7 @@ int add_program_line(basic_state_t* state, uint16_t line_number, const char* tex
         return -1;
     }
     strcpy(new_line->text, text);
+    new_line->literals = build_literal_pool(new_line->text, new_line->length);
     
     // 適切な位置に挿入（行番号順）
     program_line_t* prev = NULL;
@@ -284,8 +386,7 @@ int add_program_line(basic_state_t* state, uint16_t line_number, const char* tex
         } else {
             state->program_start = new_line;
         }
-        if (current->text) free(current->text);
-        free(current);
+        free_program_line(current);
     } else {
         // 新規挿入
         new_line->next = current;
@@ -305,7 +406,7 @@ void basic_list_program(basic_state_t* state) {
     
     program_line_t* line = state->program_start;
     while (line) {
-        printf("%d %s\n", line->line_number, line->text);
+        output_printf(state, "%d %s\n", line->line_number, line->text);
         line = line->next;
     }
 }
@@ -314,30 +415,8 @@ void basic_list_program(basic_state_t* state) {
 void basic_new_program(basic_state_t* state) {
     if (!state) return;
     
-    // プログラム行の解放
-    program_line_t* line = state->program_start;
-    while (line) {
-        program_line_t* next = line->next;
-        if (line->text) free(line->text);
-        free(line);
-        line = next;
-    }
-    state->program_start = NULL;
-    
-    // 変数の解放
-    variable_t* var = state->variables;
-    while (var) {
-        variable_t* next = var->next;
-        if (var->type == VAR_STRING && var->value.str.data) {
-            free(var->value.str.data);
-        } else if (var->type == VAR_ARRAY_NUMERIC || var->type == VAR_ARRAY_STRING) {
-            if (var->value.array.data) free(var->value.array.data);
-            if (var->value.array.dimensions) free(var->value.array.dimensions);
-        }
-        free(var);
-        var = next;
-    }
-    state->variables = NULL;
+    free_program_lines(state);
+    basic_clear_run_state(state);
     
     // 実行状態リセット
     state->current_line = NULL;
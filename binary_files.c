@@ -0,0 +1,301 @@
+#include "basic.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 数値配列と仮想メモリのバイナリ保存
+//
+//   BSAVE "file", A             数値配列 A の全要素を保存する
+//   BLOAD "file", A             読み込む（A がなければ保存時の形で作り、あれば同じ形であること）
+//   BSAVE "file", start, len    仮想メモリ（PEEK/POKE）の start から len バイトを保存する
+//   BLOAD "file" [, start]      保存時のアドレス（start を指定すればそこ）に読み込む
+//
+// ファイルは 16 バイトの見出し、配列なら各次元の上限・メモリなら開始アドレス（各 8 バイト）、本体の順。
+// 配列の本体は little-endian の double の並びで、要素の領域と直接 1 回の read/write で受け渡す
+// （big-endian の環境では前後で並びを入れ替える）。
+//
+//   0: "BSV1"  4: 種類（1 = 数値配列, 2 = 仮想メモリ）  5: 次元数  6-7: 0
+//   8: 要素数またはバイト数（little-endian 64 ビット、以下の 8 バイトの値も同じ）
+
+#define BSAVE_MAGIC "BSV1"
+#define BSAVE_HEADER_SIZE 16
+#define BSAVE_KIND_ARRAY 1
+#define BSAVE_KIND_MEMORY 2
+
+static void put_u64(uint8_t* p, uint64_t value) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= (uint64_t)p[i] << (8 * i);
+    return value;
+}
+
+// 要素の並びを little-endian との間で入れ替える（little-endian の環境では何もしない）
+static void swap_values(numeric_value_t* values, size_t count) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* b = (uint8_t*)&values[i].modern;
+        for (int j = 0; j < 4; j++) {
+            uint8_t t = b[j];
+            b[j] = b[7 - j];
+            b[7 - j] = t;
+        }
+    }
+#else
+    (void)values;
+    (void)count;
+#endif
+}
+
+static bool write_all(int fd, const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t length) {
+    char* p = (char*)data;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false; // 途中で終わったファイルも失敗
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// ファイル名と続く , を読む
+static const char* parse_path(basic_state_t* state, parser_state_t* parser, bool comma_required) {
+    eval_result_t path = evaluate_expression(state, parser);
+    if (has_error(state)) return NULL;
+    if (path.type != 1 || !path.value.str.data) {
+        set_error(state, ERR_TYPE_MISMATCH, "File name expected");
+        return NULL;
+    }
+    uint16_t save = parser->position;
+    token_t comma = get_next_token(state, parser);
+    if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') {
+        if (comma_required) {
+            set_error(state, ERR_SYNTAX, ", expected");
+            return NULL;
+        }
+        parser_rewind(parser, save);
+    }
+    return path.value.str.data;
+}
+
+// 配列名だけの引数か（名前の後が文の終わり）
+static const char* parse_array_name(basic_state_t* state, parser_state_t* parser) {
+    uint16_t save = parser->position;
+    token_t name = get_next_token(state, parser);
+    if (name.type == TOKEN_VARIABLE) {
+        uint16_t after = parser->position;
+        token_t next = get_next_token(state, parser);
+        parser_rewind(parser, after);
+        if (next.type == TOKEN_EOF || next.type == TOKEN_EOL ||
+            (next.type == TOKEN_DELIMITER && next.value.operator == ':')) {
+            return name.value.string;
+        }
+    }
+    parser_rewind(parser, save);
+    return NULL;
+}
+
+// 連続した領域を持つ数値配列か
+static bool check_numeric_array(basic_state_t* state, const variable_t* var) {
+    if (!var || var->type != VAR_ARRAY_NUMERIC) {
+        set_error(state, ERR_TYPE_MISMATCH, "Numeric array expected");
+        return false;
+    }
+    if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+        set_error(state, ERR_TYPE_MISMATCH, "Sparse array not allowed here");
+        return false;
+    }
+    return true;
+}
+
+static bool same_shape(const variable_t* var, const size_t* dimensions, uint8_t dim_count) {
+    if (var->value.array.dim_count != dim_count) return false;
+    return memcmp(var->value.array.dimensions, dimensions, dim_count * sizeof(size_t)) == 0;
+}
+
+// 仮想メモリの範囲を検査
+static bool check_memory_range(basic_state_t* state, double start, double length) {
+    if (!(start >= 0) || !(length >= 0) || start + length > VIRTUAL_MEMORY_SIZE) {
+        set_error(state, ERR_ILLEGAL_QUANTITY, NULL);
+        return false;
+    }
+    return true;
+}
+
+static double parse_number_argument(basic_state_t* state, parser_state_t* parser) {
+    eval_result_t value = evaluate_expression(state, parser);
+    if (has_error(state)) return 0.0;
+    if (value.type != 0) {
+        set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected");
+        return 0.0;
+    }
+    return trunc(numeric_to_double(value.value.num));
+}
+
+// BSAVE "file", A / BSAVE "file", start, length
+int cmd_bsave(basic_state_t* state, parser_state_t* parser_ptr) {
+    const char* path = parse_path(state, parser_ptr, true);
+    if (!path) return -1;
+
+    uint8_t header[BSAVE_HEADER_SIZE + 8 * MAX_ARRAY_DIMENSIONS] = {0};
+    size_t header_size = BSAVE_HEADER_SIZE;
+    memcpy(header, BSAVE_MAGIC, 4);
+    numeric_value_t* values = NULL;
+    const void* body;
+    size_t body_size;
+
+    const char* name = parse_array_name(state, parser_ptr);
+    if (name) {
+        variable_t* var = find_variable(state, name);
+        if (!check_numeric_array(state, var)) return -1;
+        size_t count = var->value.array.total_elements;
+        header[4] = BSAVE_KIND_ARRAY;
+        header[5] = var->value.array.dim_count;
+        put_u64(header + 8, count);
+        for (uint8_t i = 0; i < var->value.array.dim_count; i++) {
+            put_u64(header + header_size, var->value.array.dimensions[i]);
+            header_size += 8;
+        }
+        values = (numeric_value_t*)var->value.array.data;
+        body = values;
+        body_size = count * sizeof(numeric_value_t);
+    } else {
+        double start = parse_number_argument(state, parser_ptr);
+        if (has_error(state)) return -1;
+        token_t comma = get_next_token(state, parser_ptr);
+        if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') {
+            set_error(state, ERR_SYNTAX, ", expected");
+            return -1;
+        }
+        double length = parse_number_argument(state, parser_ptr);
+        if (has_error(state) || !check_memory_range(state, start, length)) return -1;
+        header[4] = BSAVE_KIND_MEMORY;
+        put_u64(header + 8, (uint64_t)length);
+        put_u64(header + header_size, (uint64_t)start);
+        header_size += 8;
+        body = virtual_memory_base() + (size_t)start;
+        body_size = (size_t)length;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+    if (values) swap_values(values, body_size / sizeof(numeric_value_t));
+    bool ok = write_all(fd, header, header_size) && write_all(fd, body, body_size);
+    if (values) swap_values(values, body_size / sizeof(numeric_value_t));
+    if (close(fd) != 0) ok = false;
+    if (!ok) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+    return 0;
+}
+
+// BLOAD "file", A / BLOAD "file" [, start]
+int cmd_bload(basic_state_t* state, parser_state_t* parser_ptr) {
+    const char* path = parse_path(state, parser_ptr, false);
+    if (!path) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+    uint8_t header[BSAVE_HEADER_SIZE + 8 * MAX_ARRAY_DIMENSIONS];
+    uint64_t count = 0;
+    bool ok = read_all(fd, header, BSAVE_HEADER_SIZE) && memcmp(header, BSAVE_MAGIC, 4) == 0;
+    if (ok) count = get_u64(header + 8);
+
+    if (ok && header[4] == BSAVE_KIND_ARRAY) {
+        uint8_t dim_count = header[5];
+        size_t dimensions[MAX_ARRAY_DIMENSIONS];
+        ok = dim_count >= 1 && dim_count <= MAX_ARRAY_DIMENSIONS &&
+             read_all(fd, header + BSAVE_HEADER_SIZE, 8 * (size_t)dim_count);
+        for (uint8_t i = 0; ok && i < dim_count; i++) {
+            uint64_t bound = get_u64(header + BSAVE_HEADER_SIZE + 8 * i);
+            ok = bound < SIZE_MAX;
+            dimensions[i] = (size_t)bound;
+        }
+        if (ok) {
+            size_t total = calculate_array_size(dimensions, dim_count);
+            ok = total != ARRAY_INDEX_INVALID && total == count && total <= SIZE_MAX / sizeof(numeric_value_t);
+        }
+        if (ok) {
+            // 配列を作る前に本体がそろっているか確かめる
+            struct stat st;
+            off_t body = (off_t)(BSAVE_HEADER_SIZE + 8 * (size_t)dim_count);
+            ok = fstat(fd, &st) == 0 && st.st_size >= body &&
+                 (uint64_t)(st.st_size - body) / sizeof(numeric_value_t) >= count;
+        }
+        if (!ok) {
+            close(fd);
+            set_error(state, ERR_FILE_IO, "Bad BSAVE file");
+            return -1;
+        }
+
+        const char* name = parse_array_name(state, parser_ptr);
+        if (!name) {
+            close(fd);
+            set_error(state, ERR_SYNTAX, "Array name expected");
+            return -1;
+        }
+        variable_t* var = find_variable(state, name);
+        if (!var && !strchr(name, '$')) var = create_array(state, name, dimensions, dim_count);
+        if (!has_error(state) && check_numeric_array(state, var) && !same_shape(var, dimensions, dim_count)) {
+            set_error(state, ERR_REDIMENSIONED_ARRAY, NULL);
+        }
+        if (has_error(state)) {
+            close(fd);
+            return -1;
+        }
+
+        numeric_value_t* values = (numeric_value_t*)var->value.array.data;
+        ok = read_all(fd, values, (size_t)count * sizeof(numeric_value_t));
+        swap_values(values, (size_t)count);
+    } else if (ok && header[4] == BSAVE_KIND_MEMORY) {
+        uint8_t address[8];
+        ok = read_all(fd, address, sizeof(address));
+        double start = ok ? (double)get_u64(address) : 0.0;
+        if (ok) {
+            uint16_t save = parser_ptr->position;
+            token_t token = get_next_token(state, parser_ptr);
+            parser_rewind(parser_ptr, save);
+            if (token.type != TOKEN_EOF && token.type != TOKEN_EOL &&
+                !(token.type == TOKEN_DELIMITER && token.value.operator == ':')) {
+                start = parse_number_argument(state, parser_ptr);
+            }
+        }
+        if (has_error(state) || (ok && !check_memory_range(state, start, (double)count))) {
+            close(fd);
+            return -1;
+        }
+        if (ok) ok = read_all(fd, virtual_memory_base() + (size_t)start, (size_t)count);
+    } else {
+        ok = false;
+    }
+
+    close(fd);
+    if (!ok) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+    return 0;
+}
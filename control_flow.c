@@ -57,7 +57,6 @@ int cmd_if(basic_state_t* state, parser_state_t* parser_ptr) {
         truthy = (numeric_to_double(cond.value.num) != 0.0);
     } else if (cond.type == 1) {
         truthy = (cond.value.str.data && cond.value.str.data[0] != '\0');
-        if (cond.value.str.data) free(cond.value.str.data);
     }
 
     // Helper: for false branch, skip only the immediate statement after THEN up to ':' or EOL
@@ -110,6 +109,15 @@ int cmd_if(basic_state_t* state, parser_state_t* parser_ptr) {
             case 0x91: rc = cmd_null(state, parser_ptr); break;           // NULL
             case 0x95: rc = cmd_def(state, parser_ptr); break;            // DEF
             case 0x98: rc = cmd_cont(state, parser_ptr); break;           // CONT
+            case 0xC5: rc = cmd_mat(state, parser_ptr); break;            // MAT
+            case 0xCD: rc = cmd_sort(state, parser_ptr); break;           // SORT
+            case 0xCE: rc = cmd_redim(state, parser_ptr); break;          // REDIM
+            case 0xCF: rc = cmd_append(state, parser_ptr); break;         // APPEND
+            case 0xD3: rc = cmd_line_input(state, parser_ptr); break;     // LINE INPUT
+            case 0xD5: rc = cmd_open(state, parser_ptr); break;           // OPEN
+            case 0xD6: rc = cmd_close(state, parser_ptr); break;          // CLOSE
+            case 0xD8: rc = cmd_bsave(state, parser_ptr); break;          // BSAVE
+            case 0xD9: rc = cmd_bload(state, parser_ptr); break;          // BLOAD
             case 0x99: basic_list_program(state); rc = 0; break;          // LIST
             case 0x9C: basic_new_program(state); rc = 0; break;           // NEW
             case 0x9D: set_error(state, ERR_UNDEF_STATEMENT, "TAB not supported as statement"); rc = -1; break;
@@ -140,7 +148,7 @@ int cmd_gosub(basic_state_t* state, parser_state_t* parser_ptr) {
     }
 
     // Push return address
-    gosub_stack_entry_t* entry = (gosub_stack_entry_t*)malloc(sizeof(gosub_stack_entry_t));
+    gosub_stack_entry_t* entry = (gosub_stack_entry_t*)arena_block_alloc(&state->heap, sizeof(gosub_stack_entry_t));
     if (!entry) { set_error(state, ERR_OUT_OF_MEMORY, NULL); return -1; }
     entry->line = state->current_line;
     entry->position = parser_ptr->position; // resume after GOSUB args
@@ -162,7 +170,7 @@ int cmd_return(basic_state_t* state, parser_state_t* parser_ptr) {
 
     state->current_line = entry->line;
     state->current_position = entry->position;
-    free(entry);
+    arena_block_free(&state->heap, entry);
     return 0;
 }
 
@@ -173,26 +181,26 @@ int cmd_for(basic_state_t* state, parser_state_t* parser_ptr) {
 
     // Only numeric loops supported
     bool is_string = (strchr(var_tok.value.string, '$') != NULL);
-    if (is_string) { set_error(state, ERR_TYPE_MISMATCH, "FOR variable must be numeric"); free(var_tok.value.string); return -1; }
+    if (is_string) { set_error(state, ERR_TYPE_MISMATCH, "FOR variable must be numeric"); return -1; }
 
     token_t eq = get_next_token(state, parser_ptr);
-    if (eq.type != TOKEN_OPERATOR || eq.value.operator != '=') { set_error(state, ERR_SYNTAX, "= expected after FOR variable"); free(var_tok.value.string); return -1; }
+    if (eq.type != TOKEN_OPERATOR || eq.value.operator != '=') { set_error(state, ERR_SYNTAX, "= expected after FOR variable"); return -1; }
 
     eval_result_t start_val = evaluate_expression(state, parser_ptr);
-    if (has_error(state) || start_val.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric start expected"); free(var_tok.value.string); return -1; }
+    if (has_error(state) || start_val.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric start expected"); return -1; }
 
     token_t to_kw = get_next_token(state, parser_ptr);
-    if (to_kw.type != TOKEN_KEYWORD || to_kw.value.keyword_id != 0x9E) { set_error(state, ERR_SYNTAX, "TO expected"); free(var_tok.value.string); return -1; }
+    if (to_kw.type != TOKEN_KEYWORD || to_kw.value.keyword_id != 0x9E) { set_error(state, ERR_SYNTAX, "TO expected"); return -1; }
 
     eval_result_t limit_val = evaluate_expression(state, parser_ptr);
-    if (has_error(state) || limit_val.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric limit expected"); free(var_tok.value.string); return -1; }
+    if (has_error(state) || limit_val.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric limit expected"); return -1; }
 
     numeric_value_t step_val = double_to_numeric(1.0);
     uint16_t save_pos = parser_ptr->position;
     token_t maybe_step = get_next_token(state, parser_ptr);
     if (maybe_step.type == TOKEN_KEYWORD && maybe_step.value.keyword_id == 0xA3) {
         eval_result_t step_expr = evaluate_expression(state, parser_ptr);
-        if (has_error(state) || step_expr.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric STEP expected"); free(var_tok.value.string); return -1; }
+        if (has_error(state) || step_expr.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric STEP expected"); return -1; }
         step_val = step_expr.value.num;
     } else {
         // rewind
@@ -202,12 +210,12 @@ int cmd_for(basic_state_t* state, parser_state_t* parser_ptr) {
 
     // Initialize/control variable
     variable_t* var = create_variable(state, var_tok.value.string, VAR_NUMERIC);
-    if (!var) { free(var_tok.value.string); return -1; }
+    if (!var) return -1;
     var->value.num = start_val.value.num;
 
     // Push FOR frame
-    for_stack_entry_t* fe = (for_stack_entry_t*)malloc(sizeof(for_stack_entry_t));
-    if (!fe) { set_error(state, ERR_OUT_OF_MEMORY, NULL); free(var_tok.value.string); return -1; }
+    for_stack_entry_t* fe = (for_stack_entry_t*)arena_block_alloc(&state->heap, sizeof(for_stack_entry_t));
+    if (!fe) { set_error(state, ERR_OUT_OF_MEMORY, NULL); return -1; }
     memset(fe, 0, sizeof(*fe));
     strncpy(fe->var_name, var_tok.value.string, sizeof(fe->var_name)-1);
     fe->limit = limit_val.value.num;
@@ -217,7 +225,6 @@ int cmd_for(basic_state_t* state, parser_state_t* parser_ptr) {
     fe->next = state->for_stack;
     state->for_stack = fe;
 
-    free(var_tok.value.string);
     return 0;
 }
 
@@ -234,21 +241,21 @@ int cmd_next(basic_state_t* state, parser_state_t* parser_ptr) {
         parser_ptr->current_char = (parser_ptr->position < parser_ptr->length) ? parser_ptr->text[parser_ptr->position] : '\0';
     }
 
-    if (!state->for_stack) { if (var_name) free(var_name); set_error(state, ERR_NEXT_WITHOUT_FOR, NULL); return -1; }
+    if (!state->for_stack) { set_error(state, ERR_NEXT_WITHOUT_FOR, NULL); return -1; }
 
     // Find matching FOR frame (top-most, or by name)
     for_stack_entry_t* prev = NULL;
     for_stack_entry_t* cur = state->for_stack;
     if (var_name) {
         while (cur && strcmp(cur->var_name, var_name) != 0) { prev = cur; cur = cur->next; }
-        if (!cur) { free(var_name); set_error(state, ERR_NEXT_WITHOUT_FOR, NULL); return -1; }
+        if (!cur) { set_error(state, ERR_NEXT_WITHOUT_FOR, NULL); return -1; }
     }
 
     if (!cur) { cur = state->for_stack; }
 
     // Increment the loop variable
     variable_t* v = find_variable(state, cur->var_name);
-    if (!v || v->type != VAR_NUMERIC) { if (var_name) free(var_name); set_error(state, ERR_UNDEF_STATEMENT, "FOR variable missing"); return -1; }
+    if (!v || v->type != VAR_NUMERIC) { set_error(state, ERR_UNDEF_STATEMENT, "FOR variable missing"); return -1; }
 
     double step = numeric_to_double(cur->step);
     double new_val = numeric_to_double(v->value.num) + step;
@@ -265,10 +272,9 @@ int cmd_next(basic_state_t* state, parser_state_t* parser_ptr) {
     } else {
         // Pop this frame
         if (prev) prev->next = cur->next; else state->for_stack = cur->next;
-        free(cur);
+        arena_block_free(&state->heap, cur);
     }
 
-    if (var_name) free(var_name);
     return 0;
 }
 
@@ -317,7 +323,7 @@ int cmd_on_goto(basic_state_t* state, parser_state_t* parser_ptr) {
 
     if (do_gosub) {
         // Push return info
-        gosub_stack_entry_t* entry = (gosub_stack_entry_t*)malloc(sizeof(gosub_stack_entry_t));
+        gosub_stack_entry_t* entry = (gosub_stack_entry_t*)arena_block_alloc(&state->heap, sizeof(gosub_stack_entry_t));
         if (!entry) { set_error(state, ERR_OUT_OF_MEMORY, NULL); return -1; }
         entry->line = state->current_line;
         entry->position = parser_ptr->position;
@@ -0,0 +1,139 @@
+#include "basic.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// CSV ファイルを DATA の代わりに読む
+//
+//   DATA FILE "input.csv"   以後の READ はファイルのフィールドを順に読む
+//   RESTORE                 ファイルの先頭に戻る
+//   RESTORE 行番号          ファイルを閉じてプログラムの DATA に戻る
+//
+// ファイルは読み取り専用でマップし、フィールドは READ のたびにその場で切り出す。
+// レコードの区切り（改行）はフィールドの区切りと同じに扱い、空行は読み飛ばす。
+// 引用符で囲んだフィールドは , と改行を含められ、"" は " 1文字を表す。
+
+// ファイルを閉じる（CLEAR/RUN/NEW と DATA FILE の開き直し）
+void close_data_file(basic_state_t* state) {
+    data_file_t* file = &state->data_file;
+    if (file->text) munmap((void*)file->text, file->length);
+    memset(file, 0, sizeof(*file));
+}
+
+int open_data_file(basic_state_t* state, const char* path) {
+    close_data_file(state);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uintmax_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+    size_t length = (size_t)st.st_size;
+    void* addr = NULL;
+    if (length > 0) {
+        addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            set_error(state, ERR_FILE_IO, NULL);
+            return -1;
+        }
+        posix_madvise(addr, length, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd); // マップはファイルを閉じても有効
+
+    data_file_t* file = &state->data_file;
+    file->text = (const char*)addr;
+    file->length = length;
+    file->cursor = 0;
+    file->active = true;
+    return 0;
+}
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static bool is_record_end(char c) {
+    return c == '\n' || c == '\r';
+}
+
+// 次のフィールド（一時領域に切り出す、なければ OUT OF DATA）
+const data_item_t* read_data_file_field(basic_state_t* state) {
+    data_file_t* file = &state->data_file;
+    const char* text = file->text;
+    size_t end = file->length;
+    size_t pos = file->cursor;
+
+    if (file->after_comma) {
+        // , の直後がレコードの終わりなら空のフィールド（改行は次のレコードの先頭で読み飛ばす）
+        file->after_comma = false;
+        if (pos >= end || is_record_end(text[pos])) {
+            file->cursor = pos;
+            file->item.text = scratch_string(state, "", 0);
+            file->item.num = double_to_numeric(0.0);
+            return file->item.text ? &file->item : NULL;
+        }
+    } else {
+        // レコードの先頭の空行を読み飛ばす
+        while (pos < end && is_record_end(text[pos])) pos++;
+        if (pos >= end) {
+            file->cursor = end;
+            set_error(state, ERR_OUT_OF_DATA, NULL);
+            return NULL;
+        }
+    }
+
+    char* field;
+    size_t p = pos;
+    while (p < end && is_blank(text[p])) p++;
+    if (p < end && text[p] == '"') {
+        // 引用符付き - 閉じ引用符までの長さを求めてから "" を戻しつつ複製
+        size_t start = ++p;
+        size_t length = 0;
+        while (p < end && !(text[p] == '"' && (p + 1 >= end || text[p + 1] != '"'))) {
+            p += (text[p] == '"') ? 2 : 1;
+            length++;
+        }
+        field = (char*)arena_alloc(&state->scratch, length + 1);
+        if (!field) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
+            return NULL;
+        }
+        for (size_t i = start, k = 0; k < length; k++) {
+            field[k] = text[i];
+            i += (text[i] == '"') ? 2 : 1;
+        }
+        field[length] = '\0';
+        if (p < end) p++; // 閉じ引用符
+        while (p < end && text[p] != ',' && !is_record_end(text[p])) p++;
+    } else {
+        size_t start = p;
+        while (p < end && text[p] != ',' && !is_record_end(text[p])) p++;
+        size_t stop = p;
+        while (stop > start && is_blank(text[stop - 1])) stop--;
+        field = scratch_string(state, text + start, stop - start);
+        if (!field) return NULL;
+    }
+    if (p < end && text[p] == ',') {
+        p++;
+        file->after_comma = true;
+    }
+    file->cursor = p;
+
+    file->item.text = field;
+    file->item.num = double_to_numeric(0.0);
+    return &file->item;
+}
+
+// ファイルの先頭に戻る
+void rewind_data_file(basic_state_t* state) {
+    state->data_file.cursor = 0;
+    state->data_file.after_comma = false;
+}
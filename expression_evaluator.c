@@ -26,12 +26,12 @@ extern numeric_value_t func_peek(uint16_t address);
 // 文字列関数の宣言
 extern eval_result_t func_len(const char* str);
 extern eval_result_t func_asc(const char* str);
-extern eval_result_t func_chr(int ascii_code);
-extern eval_result_t func_str(numeric_value_t num);
+extern eval_result_t func_chr(basic_state_t* state, int ascii_code);
+extern eval_result_t func_str(basic_state_t* state, numeric_value_t num);
 extern eval_result_t func_val(const char* str);
-extern eval_result_t func_left(const char* str, int n);
-extern eval_result_t func_right(const char* str, int n);
-extern eval_result_t func_mid(const char* str, int start, int len);
+extern eval_result_t func_left(basic_state_t* state, const char* str, int n);
+extern eval_result_t func_right(basic_state_t* state, const char* str, int n);
+extern eval_result_t func_mid(basic_state_t* state, const char* str, int start, int len);
 
 // 算術演算の宣言
 extern numeric_value_t math_add(numeric_value_t a, numeric_value_t b);
@@ -61,7 +61,7 @@ extern int string_greater_equal(const char* str1, const char* str2);
 extern int string_not_equal(const char* str1, const char* str2);
 
 // 文字列連結の宣言
-extern eval_result_t string_concatenate(const char* str1, const char* str2);
+extern eval_result_t string_concatenate(basic_state_t* state, const char* str1, const char* str2);
 
 // 演算子優先度テーブル
 typedef struct {
@@ -94,16 +94,6 @@ const operator_info_t* get_operator_info(char op) {
     return NULL;
 }
 
-// Rewind parser to a prior token start position
-static void parser_rewind(parser_state_t* parser, uint16_t pos) {
-    if (!parser) return;
-    if (pos > parser->length) pos = parser->length;
-    parser->position = pos;
-    parser->current_char = (parser->position < parser->length)
-        ? parser->text[parser->position]
-        : '\0';
-}
-
 // 前方宣言
 eval_result_t evaluate_expression_with_precedence(basic_state_t* state, parser_state_t* parser_ptr, uint8_t min_precedence);
 eval_result_t evaluate_primary(basic_state_t* state, parser_state_t* parser_ptr);
@@ -190,23 +180,14 @@ eval_result_t evaluate_expression_with_precedence(basic_state_t* state, parser_s
                 }
             } else {
                 set_error(state, ERR_TYPE_MISMATCH, "Type mismatch in comparison");
-                // free any strings
-                if (left.type == 1 && left.value.str.data) free(left.value.str.data);
-                if (right.type == 1 && right.value.str.data) free(right.value.str.data);
                 return res;
             }
-            // clean up any string operands as perform_operation would
-            if (left.type == 1 && left.value.str.data) free(left.value.str.data);
-            if (right.type == 1 && right.value.str.data) free(right.value.str.data);
             left = res;
             if (has_error(state)) return left;
         } else if (effective_op == '&' || effective_op == '|') {
             // Bitwise AND/OR (numeric only)
             if (left.type != 0 || right.type != 0) {
                 set_error(state, ERR_TYPE_MISMATCH, "AND/OR require numeric operands");
-                // free any strings
-                if (left.type == 1 && left.value.str.data) free(left.value.str.data);
-                if (right.type == 1 && right.value.str.data) free(right.value.str.data);
                 return left;
             }
             eval_result_t res = {0};
@@ -243,7 +224,6 @@ eval_result_t evaluate_primary(basic_state_t* state, parser_state_t* parser_ptr)
             
         case TOKEN_VARIABLE:
             result = evaluate_variable(state, parser_ptr, token.value.string);
-            free(token.value.string);
             break;
             
         case TOKEN_KEYWORD:
@@ -308,31 +288,22 @@ eval_result_t evaluate_variable(basic_state_t* state, parser_state_t* parser_ptr
         uint16_t save_pos = parser_ptr->position;
     token_t next_token = get_next_token(state, parser_ptr);
     if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == '(') {
-        // 配列アクセス
-        uint16_t indices[MAX_ARRAY_DIMENSIONS];
+        // 配列アクセス（配列変数は添字の評価前に一度だけ解決する）
+        variable_t* array_var = find_variable(state, var_name);
+        if (array_var && (array_var->type == VAR_MAP_NUMERIC || array_var->type == VAR_MAP_STRING)) {
+            // 連想配列の要素
+            const char* key;
+            uint32_t key_length;
+            if (parse_map_key(state, parser_ptr, &key, &key_length) != 0) return result;
+            return access_map_element(state, array_var, key, key_length);
+        }
+        size_t indices[MAX_ARRAY_DIMENSIONS];
         uint8_t index_count = 0;
-        
-        while (index_count < MAX_ARRAY_DIMENSIONS) {
-            eval_result_t index_result = evaluate_expression(state, parser_ptr);
-            if (has_error(state) || index_result.type != 0) {
-                set_error(state, ERR_TYPE_MISMATCH, "Numeric index expected");
-                return result;
-            }
-            
-            indices[index_count++] = (uint16_t)numeric_to_double(index_result.value.num);
-            
-            token_t sep_token = get_next_token(state, parser_ptr);
-            if (sep_token.type == TOKEN_DELIMITER && sep_token.value.operator == ',') {
-                continue; // 次のインデックスへ
-            } else if (sep_token.type == TOKEN_DELIMITER && sep_token.value.operator == ')') {
-                break; // インデックス終了
-            } else {
-                set_error(state, ERR_SYNTAX, ", or ) expected in array access");
-                return result;
-            }
+        if (parse_array_subscripts(state, parser_ptr, indices, &index_count) != 0) {
+            return result;
         }
         
-        result = access_array_element(state, var_name, indices, index_count);
+        result = access_array_element(state, array_var, indices, index_count);
     } else {
         // not an array access; rewind so caller sees following token
         parser_ptr->position = save_pos;
@@ -344,11 +315,8 @@ eval_result_t evaluate_variable(basic_state_t* state, parser_state_t* parser_ptr
             bool is_string = strchr(var_name, '$') != NULL;
             if (is_string) {
                 result.type = 1;
-                result.value.str.data = (char*)malloc(1);
-                if (result.value.str.data) {
-                    result.value.str.data[0] = '\0';
-                    result.value.str.length = 0;
-                }
+                result.value.str.data = scratch_string(state, "", 0);
+                result.value.str.length = 0;
             } else {
                 result.type = 0;
                 result.value.num = double_to_numeric(0.0);
@@ -359,8 +327,21 @@ eval_result_t evaluate_variable(basic_state_t* state, parser_state_t* parser_ptr
                 result.value.num = var->value.num;
             } else if (var->type == VAR_STRING) {
                 result.type = 1;
-                result.value.str.data = safe_string_dup(var->value.str.data, MAX_STRING_LENGTH);
-                result.value.str.length = result.value.str.data ? strlen(result.value.str.data) : 0;
+                const char* text = variable_string(var);
+                if (var->value.str.rope) {
+                    // ロープは平坦化した葉をそのまま返す（この変数へ次に代入するまで有効）
+                    if (!text) {
+                        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+                        return result;
+                    }
+                    result.value.str.data = (char*)text;
+                    result.value.str.length = (uint32_t)rope_length(var->value.str.rope);
+                } else {
+                    size_t len = text ? strlen(text) : 0;
+                    if (len > string_limit(state)) len = string_limit(state);
+                    result.value.str.data = scratch_string(state, text, len);
+                    result.value.str.length = result.value.str.data ? (uint32_t)len : 0;
+                }
             } else {
                 set_error(state, ERR_TYPE_MISMATCH, "Invalid variable type");
             }
@@ -421,6 +402,22 @@ eval_result_t evaluate_function(basic_state_t* state, parser_state_t* parser_ptr
         case 0xC0: // ASC
         case 0xBF: // VAL
         {
+            if (function_id == 0xBD) {
+                // LEN(A$) のロープは平坦化せずに長さを返す
+                uint16_t save = parser_ptr->position;
+                token_t name = get_next_token(state, parser_ptr);
+                uint16_t after = parser_ptr->position;
+                token_t close = get_next_token(state, parser_ptr);
+                variable_t* var = (name.type == TOKEN_VARIABLE) ? find_variable(state, name.value.string) : NULL;
+                if (var && var->type == VAR_STRING && var->value.str.rope &&
+                    close.type == TOKEN_DELIMITER && close.value.operator == ')') {
+                    parser_rewind(parser_ptr, after);
+                    result.type = 0;
+                    result.value.num = double_to_numeric((double)rope_length(var->value.str.rope));
+                    break;
+                }
+                parser_rewind(parser_ptr, save);
+            }
             eval_result_t arg = evaluate_expression(state, parser_ptr);
             if (has_error(state) || arg.type != 1) {
                 set_error(state, ERR_TYPE_MISMATCH, "String argument expected");
@@ -432,8 +429,6 @@ eval_result_t evaluate_function(basic_state_t* state, parser_state_t* parser_ptr
                 case 0xC0: result = func_asc(arg.value.str.data); break;
                 case 0xBF: result = func_val(arg.value.str.data); break;
             }
-            
-            if (arg.value.str.data) free(arg.value.str.data);
             break;
         }
         
@@ -447,8 +442,8 @@ eval_result_t evaluate_function(basic_state_t* state, parser_state_t* parser_ptr
             }
             
             switch (function_id) {
-                case 0xC1: result = func_chr((int)numeric_to_double(arg.value.num)); break;
-                case 0xBE: result = func_str(arg.value.num); break;
+                case 0xC1: result = func_chr(state, (int)numeric_to_double(arg.value.num)); break;
+                case 0xBE: result = func_str(state, arg.value.num); break;
             }
             break;
         }
@@ -462,27 +457,26 @@ eval_result_t evaluate_function(basic_state_t* state, parser_state_t* parser_ptr
             if (has_error(state) || s.type != 1) { set_error(state, ERR_TYPE_MISMATCH, "String argument expected"); return result; }
             // Comma
             token_t comma = get_next_token(state, parser_ptr);
-            if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') { set_error(state, ERR_SYNTAX, ", expected"); if (s.value.str.data) free(s.value.str.data); return result; }
+            if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') { set_error(state, ERR_SYNTAX, ", expected"); return result; }
             // Numeric parameter(s)
             eval_result_t p1 = evaluate_expression(state, parser_ptr);
-            if (has_error(state) || p1.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected"); if (s.value.str.data) free(s.value.str.data); return result; }
+            if (has_error(state) || p1.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected"); return result; }
             if (function_id == 0xC4) {
                 // MID$(s$, start, len)
                 token_t comma2 = get_next_token(state, parser_ptr);
-                if (comma2.type != TOKEN_DELIMITER || comma2.value.operator != ',') { set_error(state, ERR_SYNTAX, ", expected"); if (s.value.str.data) free(s.value.str.data); return result; }
+                if (comma2.type != TOKEN_DELIMITER || comma2.value.operator != ',') { set_error(state, ERR_SYNTAX, ", expected"); return result; }
                 eval_result_t p2 = evaluate_expression(state, parser_ptr);
-                if (has_error(state) || p2.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected"); if (s.value.str.data) free(s.value.str.data); return result; }
+                if (has_error(state) || p2.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected"); return result; }
                 int start = (int)numeric_to_double(p1.value.num);
                 int len = (int)numeric_to_double(p2.value.num);
-                result = func_mid(s.value.str.data, start, len);
+                result = func_mid(state, s.value.str.data, start, len);
             } else if (function_id == 0xC2) {
                 int n = (int)numeric_to_double(p1.value.num);
-                result = func_left(s.value.str.data, n);
+                result = func_left(state, s.value.str.data, n);
             } else { // RIGHT$
                 int n = (int)numeric_to_double(p1.value.num);
-                result = func_right(s.value.str.data, n);
+                result = func_right(state, s.value.str.data, n);
             }
-            if (s.value.str.data) free(s.value.str.data);
             break;
         }
 
@@ -505,6 +499,34 @@ eval_result_t evaluate_function(basic_state_t* state, parser_state_t* parser_ptr
             break;
         }
         
+        case 0xC6: // SUM
+        case 0xC7: // MIN
+        case 0xC8: // MAX
+        case 0xC9: // MEAN
+        case 0xCA: // DOT
+        case 0xCB: // COUNT
+            result = func_array_aggregate(state, parser_ptr, function_id);
+            if (has_error(state)) return result;
+            break;
+
+        case 0xCC: // BSEARCH
+            result = func_bsearch(state, parser_ptr);
+            if (has_error(state)) return result;
+            break;
+
+        case 0xD0: // HASKEY
+        case 0xD1: // KEYS
+        case 0xD2: // KEY$
+            result = func_map(state, parser_ptr, function_id);
+            if (has_error(state)) return result;
+            break;
+
+        case 0xD4: // EOF
+        case 0xD7: // LOF
+            result = func_file(state, parser_ptr, function_id);
+            if (has_error(state)) return result;
+            break;
+        
         // 複数引数の文字列関数は別途実装
         default:
             set_error(state, ERR_UNDEF_FUNCTION, "Function not implemented");
@@ -530,7 +552,12 @@ eval_result_t perform_operation(basic_state_t* state, eval_result_t left, char o
         const char* left_str = (left.type == 1) ? left.value.str.data : "";
         const char* right_str = (right.type == 1) ? right.value.str.data : "";
         
-        result = string_concatenate(left_str, right_str);
+        if (state->long_strings &&
+            strlen(left_str ? left_str : "") + strlen(right_str ? right_str : "") > MAX_LONG_STRING_LENGTH) {
+            set_error(state, ERR_STRING_TOO_LONG, NULL);
+        } else {
+            result = string_concatenate(state, left_str, right_str);
+        }
     } else if (left.type == 0 && right.type == 0) {
         // 数値演算
         result.type = 0;
@@ -590,10 +617,6 @@ eval_result_t perform_operation(basic_state_t* state, eval_result_t left, char o
         set_error(state, ERR_TYPE_MISMATCH, "Type mismatch in operation");
     }
     
-    // メモリクリーンアップ
-    if (left.type == 1 && left.value.str.data) free(left.value.str.data);
-    if (right.type == 1 && right.value.str.data) free(right.value.str.data);
-    
     return result;
 }
 
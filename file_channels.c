@@ -0,0 +1,235 @@
+#include "basic.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 番号付きのファイル（順編成）
+//
+//   OPEN "out.txt" FOR OUTPUT AS #1    作り直して書く（APPEND なら末尾に追加）
+//   OPEN "in.txt" FOR INPUT AS #2      読む
+//   PRINT #1, A; ","; B$               PRINT と同じ書式で書く
+//   INPUT #2, A, B$                    1行を INPUT と同じ規則でフィールドに分ける
+//   LINE INPUT #2, L$                  1行をそのまま読む
+//   EOF(2) LOF(2)                      終わりなら -1 / ファイルの長さ（EOF(0) は標準入力）
+//   CLOSE #1, #2                       閉じる（番号を省くとすべて、END・RUN・CLEAR でも閉じる）
+//
+// 書き込みは標準出力と同じ output_t に溜めて満杯になったときと CLOSE で書き出す。
+// 読み取りは標準入力と同じ input_reader_t で、通常のファイルはマップして読み、
+// パイプなどマップできないものは大きな領域に read する。
+
+// チャネルを閉じる（書き込みに失敗していたら -1）
+static int close_channel(basic_state_t* state, int number) {
+    file_channel_t* file = state->files[number];
+    if (!file) return 0;
+    bool failed = false;
+    if (file->out) {
+        output_drain(file->out);
+        failed = file->out->failed;
+        free(file->out);
+    } else {
+        input_release(&file->in);
+    }
+    if (close(file->fd) != 0) failed = true;
+    free(file);
+    state->files[number] = NULL;
+    return failed ? -1 : 0;
+}
+
+// すべて閉じる（END・RUN・CLEAR・NEW と終了時）
+int close_all_files(basic_state_t* state) {
+    int rc = 0;
+    for (int i = 1; i <= MAX_FILE_CHANNELS; i++) {
+        if (close_channel(state, i) != 0) rc = -1;
+    }
+    if (rc != 0 && !has_error(state)) set_error(state, ERR_FILE_IO, NULL);
+    return rc;
+}
+
+// ファイル番号の値を検査（1〜MAX_FILE_CHANNELS でなければ BAD FILE NUMBER）
+static int file_number(basic_state_t* state, eval_result_t value) {
+    if (value.type != 0) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return -1;
+    }
+    double n = trunc(numeric_to_double(value.value.num));
+    if (!(n >= 1) || n > MAX_FILE_CHANNELS) {
+        set_error(state, ERR_BAD_FILE_NUMBER, NULL);
+        return -1;
+    }
+    return (int)n;
+}
+
+// [#]n を読む
+static int parse_file_number(basic_state_t* state, parser_state_t* parser) {
+    uint16_t save = parser->position;
+    token_t hash = get_next_token(state, parser);
+    if (hash.type != TOKEN_DELIMITER || hash.value.operator != '#') parser_rewind(parser, save);
+    eval_result_t value = evaluate_expression(state, parser);
+    if (has_error(state)) return -1;
+    return file_number(state, value);
+}
+
+// 番号の値から開いているチャネルを返す
+static file_channel_t* channel_from_value(basic_state_t* state, eval_result_t value) {
+    int number = file_number(state, value);
+    if (number < 0) return NULL;
+    if (!state->files[number]) {
+        set_error(state, ERR_BAD_FILE_NUMBER, NULL);
+        return NULL;
+    }
+    return state->files[number];
+}
+
+// # の直後から番号を読み、開いているチャネルを返す（書き込み用か読み取り用かも検査）
+file_channel_t* parse_file_channel(basic_state_t* state, parser_state_t* parser, bool writing) {
+    eval_result_t value = evaluate_expression(state, parser);
+    if (has_error(state)) return NULL;
+    file_channel_t* file = channel_from_value(state, value);
+    if (file && (file->mode != FILE_MODE_INPUT) != writing) {
+        set_error(state, ERR_BAD_FILE_MODE, NULL);
+        return NULL;
+    }
+    return file;
+}
+
+// OPEN "file" FOR INPUT|OUTPUT|APPEND AS [#]n
+int cmd_open(basic_state_t* state, parser_state_t* parser_ptr) {
+    eval_result_t path = evaluate_expression(state, parser_ptr);
+    if (has_error(state)) return -1;
+    if (path.type != 1 || !path.value.str.data) {
+        set_error(state, ERR_TYPE_MISMATCH, "File name expected");
+        return -1;
+    }
+
+    token_t token = get_next_token(state, parser_ptr);
+    if (token.type != TOKEN_KEYWORD || token.value.keyword_id != KW_FOR) {
+        set_error(state, ERR_SYNTAX, "FOR expected in OPEN");
+        return -1;
+    }
+    file_mode_t mode;
+    token = get_next_token(state, parser_ptr);
+    if (token.type == TOKEN_KEYWORD && token.value.keyword_id == KW_INPUT) {
+        mode = FILE_MODE_INPUT;
+    } else if (token.type == TOKEN_KEYWORD && token.value.keyword_id == KW_APPEND) {
+        mode = FILE_MODE_APPEND;
+    } else if (token.type == TOKEN_VARIABLE && strcmp(token.value.string, "OUTPUT") == 0) {
+        mode = FILE_MODE_OUTPUT;
+    } else {
+        set_error(state, ERR_SYNTAX, "INPUT, OUTPUT or APPEND expected");
+        return -1;
+    }
+    token = get_next_token(state, parser_ptr);
+    if (token.type != TOKEN_VARIABLE || strcmp(token.value.string, "AS") != 0) {
+        set_error(state, ERR_SYNTAX, "AS expected in OPEN");
+        return -1;
+    }
+    int number = parse_file_number(state, parser_ptr);
+    if (number < 0) return -1;
+    if (state->files[number]) {
+        set_error(state, ERR_FILE_ALREADY_OPEN, NULL);
+        return -1;
+    }
+
+    int flags = O_RDONLY;
+    if (mode == FILE_MODE_OUTPUT) flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (mode == FILE_MODE_APPEND) flags = O_WRONLY | O_CREAT | O_APPEND;
+    int fd = open(path.value.str.data, flags, 0666);
+    if (fd < 0) {
+        set_error(state, ERR_FILE_IO, NULL);
+        return -1;
+    }
+
+    file_channel_t* file = (file_channel_t*)calloc(1, sizeof(file_channel_t));
+    output_t* out = (mode != FILE_MODE_INPUT) ? (output_t*)malloc(sizeof(output_t)) : NULL;
+    if (!file || (mode != FILE_MODE_INPUT && !out)) {
+        free(file);
+        free(out);
+        close(fd);
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    file->mode = mode;
+    file->fd = fd;
+    if (out) {
+        output_init(out, fd);
+        out->flush = OUTPUT_FLUSH_BLOCK;
+        file->out = out;
+    } else {
+        input_init(&file->in, fd);
+        file->in.interactive = false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (uintmax_t)st.st_size <= SIZE_MAX) {
+            input_map(&file->in, fd, (size_t)st.st_size); // 失敗したら read で読む
+        }
+    }
+    state->files[number] = file;
+    return 0;
+}
+
+// CLOSE [[#]n [, [#]n ...]]
+int cmd_close(basic_state_t* state, parser_state_t* parser_ptr) {
+    uint16_t save = parser_ptr->position;
+    token_t token = get_next_token(state, parser_ptr);
+    parser_rewind(parser_ptr, save);
+    if (token.type == TOKEN_EOF || token.type == TOKEN_EOL ||
+        (token.type == TOKEN_DELIMITER && token.value.operator == ':')) {
+        return close_all_files(state);
+    }
+
+    while (true) {
+        int number = parse_file_number(state, parser_ptr);
+        if (number < 0) return -1;
+        if (close_channel(state, number) != 0) {
+            set_error(state, ERR_FILE_IO, NULL);
+            return -1;
+        }
+        save = parser_ptr->position;
+        token = get_next_token(state, parser_ptr);
+        if (token.type == TOKEN_DELIMITER && token.value.operator == ',') continue;
+        parser_rewind(parser_ptr, save); // 区切りの ':' は呼び出し側で読む
+        return 0;
+    }
+}
+
+// EOF(n) LOF(n) - 開き括弧の直後から呼ばれ、閉じ括弧は呼び出し側で読む
+// EOF() と EOF(0) は標準入力
+eval_result_t func_file(basic_state_t* state, parser_state_t* parser, uint8_t function_id) {
+    eval_result_t result = {0};
+    uint16_t save = parser->position;
+    token_t peek = get_next_token(state, parser);
+    parser_rewind(parser, save);
+
+    file_channel_t* file = NULL;
+    if (function_id != KW_EOF || peek.type != TOKEN_DELIMITER || peek.value.operator != ')') {
+        eval_result_t value = evaluate_expression(state, parser);
+        if (has_error(state)) return result;
+        bool console = (function_id == KW_EOF && value.type == 0 && numeric_to_double(value.value.num) == 0.0);
+        if (!console && !(file = channel_from_value(state, value))) return result;
+        if (file && function_id == KW_EOF && file->mode != FILE_MODE_INPUT) {
+            set_error(state, ERR_BAD_FILE_MODE, NULL);
+            return result;
+        }
+    }
+
+    result.type = 0;
+    if (function_id == KW_EOF) {
+        input_reader_t* in = file ? &file->in : &state->input;
+        result.value.num = double_to_numeric(input_at_eof(state, in) ? -1.0 : 0.0);
+        return result;
+    }
+
+    // LOF
+    double length;
+    if (file->in.mapped) {
+        length = (double)file->in.capacity;
+    } else {
+        struct stat st;
+        if (fstat(file->fd, &st) != 0) {
+            set_error(state, ERR_FILE_IO, NULL);
+            return result;
+        }
+        length = (double)st.st_size + (file->out ? (double)file->out->used : 0.0);
+    }
+    result.value.num = double_to_numeric(length);
+    return result;
+}
@@ -0,0 +1,131 @@
+#include "basic.h"
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 行単位の入力（標準入力と INPUT# のファイル）
+//
+// 直接入力の行、INPUT、LINE INPUT、GET、INPUT# はすべてここを通して読む。
+// read(2) で大きな領域にまとめて読み込み、行はその場で NUL 終端して返すので
+// 行ごとの複製はない。返した行は次に読むまで有効（読み足すときに詰め直すため）。
+// 領域に収まらない長い行は領域を倍に広げて読む（行の長さに上限はない）。
+// 標準入力では実際に read で待つ前にだけ出力を書き出すので、パイプの入力では
+// 書き出しはレコードごとではなく読み込み領域ごとになる。
+//
+// 通常のファイルは読み取り専用でマップして読む（input_map）。マップは書き換えられない
+// ので、行は一時領域に写して NUL 終端する。
+
+void input_init(input_reader_t* in, int fd) {
+    in->fd = fd;
+    in->interactive = isatty(fd);
+    in->mapped = false;
+    in->buffer = NULL;
+    in->capacity = 0;
+    in->start = 0;
+    in->end = 0;
+    in->eof = false;
+}
+
+// ファイル全体をマップして読む（マップできなければ -1、read で読む）
+int input_map(input_reader_t* in, int fd, size_t length) {
+    if (length == 0) return -1;
+    void* addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) return -1;
+    posix_madvise(addr, length, POSIX_MADV_SEQUENTIAL);
+    in->mapped = true;
+    in->buffer = (char*)addr;
+    in->capacity = length;
+    in->start = 0;
+    in->end = length;
+    in->eof = true; // 読み足すものはない
+    return 0;
+}
+
+void input_release(input_reader_t* in) {
+    if (in->mapped) munmap(in->buffer, in->capacity);
+    else free(in->buffer);
+    in->mapped = false;
+    in->buffer = NULL;
+    in->capacity = 0;
+    in->start = in->end = 0;
+}
+
+// 読み足す（未処理分を先頭に詰め、満杯なら広げる）。読めなければ -1
+static int input_fill(basic_state_t* state, input_reader_t* in) {
+    if (in->eof) return -1;
+    if (in->start > 0) {
+        memmove(in->buffer, in->buffer + in->start, in->end - in->start);
+        in->end -= in->start;
+        in->start = 0;
+    }
+    // 末尾の NUL 用に 1 バイト残す
+    if (in->end + 1 >= in->capacity) {
+        size_t capacity = in->capacity ? in->capacity * 2 : INPUT_BUFFER_SIZE;
+        char* buffer = (char*)realloc(in->buffer, capacity);
+        if (!buffer) {
+            set_error(state, ERR_OUT_OF_MEMORY, NULL);
+            return -1;
+        }
+        in->buffer = buffer;
+        in->capacity = capacity;
+    }
+    if (in == &state->input) output_flush(state);
+    while (true) {
+        ssize_t n = read(in->fd, in->buffer + in->end, in->capacity - 1 - in->end);
+        if (n > 0) {
+            in->end += (size_t)n;
+            return 0;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        in->eof = true; // 読み取りエラーも終わりとして扱う
+        return -1;
+    }
+}
+
+// マップしたファイルの次の行（一時領域に写す）
+static char* input_mapped_line(basic_state_t* state, input_reader_t* in, size_t* length) {
+    if (in->start >= in->end) return NULL;
+    const char* text = in->buffer + in->start;
+    const char* newline = (const char*)memchr(text, '\n', in->end - in->start);
+    size_t stop = newline ? (size_t)(newline - in->buffer) : in->end;
+    size_t len = stop - in->start;
+    in->start = newline ? stop + 1 : in->end;
+    if (len > 0 && text[len - 1] == '\r') len--;
+    char* line = scratch_string(state, text, len);
+    if (line && length) *length = len;
+    return line;
+}
+
+// 次の行（改行を除き NUL 終端、入力の終わりなら NULL）
+char* input_read_line(basic_state_t* state, input_reader_t* in, size_t* length) {
+    if (in->mapped) return input_mapped_line(state, in, length);
+    size_t scanned = in->start;
+    while (true) {
+        char* newline = in->end > scanned ? (char*)memchr(in->buffer + scanned, '\n', in->end - scanned) : NULL;
+        if (newline || (in->eof && in->start < in->end)) {
+            char* line = in->buffer + in->start;
+            size_t stop = newline ? (size_t)(newline - in->buffer) : in->end;
+            in->start = newline ? stop + 1 : in->end;
+            if (stop > (size_t)(line - in->buffer) && in->buffer[stop - 1] == '\r') stop--;
+            in->buffer[stop] = '\0';
+            if (length) *length = (size_t)(in->buffer + stop - line);
+            return line;
+        }
+        // 詰め直すと位置がずれるので、調べ終えた長さで覚えておく
+        size_t done = in->end - in->start;
+        if (input_fill(state, in) != 0 && !(in->eof && in->start < in->end)) return NULL;
+        scanned = in->start + done;
+    }
+}
+
+// 1文字（入力の終わりなら -1）
+int input_read_char(basic_state_t* state, input_reader_t* in) {
+    if (in->start >= in->end && input_fill(state, in) != 0) return -1;
+    return (unsigned char)in->buffer[in->start++];
+}
+
+// 入力の終わりか（必要なら読み足して確かめる）
+bool input_at_eof(basic_state_t* state, input_reader_t* in) {
+    if (in->start < in->end) return false;
+    return input_fill(state, in) != 0;
+}
@@ -7,52 +7,66 @@ extern variable_t* create_variable(basic_state_t* state, const char* name, varia
 extern numeric_value_t double_to_numeric(double d);
 
 // helper: parse next field from input line (handles quoted strings and commas)
+// Fields are sliced out of the line in place: quotes are unescaped over the
+// field itself and the field is NUL-terminated, so nothing is allocated.
 static char* parse_field_quoted(char** pcur) {
     if (!pcur || !*pcur) return NULL;
     char* s = *pcur;
     while (*s == ' ' || *s == '\t') s++;
-    char* out = NULL;
+    char* out;
     if (*s == '"') {
-        s++;
-        size_t cap = strlen(s) + 1;
-        out = (char*)malloc(cap);
-        if (!out) return NULL;
-        size_t oi = 0;
+        out = ++s;
+        char* w = s;
         while (*s) {
             if (*s == '"') {
-                if (*(s+1) == '"') { out[oi++]='"'; s+=2; continue; }
+                if (*(s+1) == '"') { *w++ = '"'; s += 2; continue; }
                 s++; // closing quote
                 break;
             }
-            out[oi++] = *s++;
+            *w++ = *s++;
         }
-        out[oi] = '\0';
         while (*s == ' ' || *s == '\t') s++;
         if (*s == ',') s++;
+        *w = '\0'; // w never passes the closing quote, so s is unaffected
     } else {
-        char* start = s;
+        out = s;
         while (*s && *s != ',') s++;
-        size_t len = (size_t)(s - start);
-        while (len > 0 && (start[len-1] == ' ' || start[len-1] == '\t')) len--;
-        out = (char*)malloc(len + 1);
-        if (!out) return NULL;
-        memcpy(out, start, len);
-        out[len] = '\0';
+        size_t len = (size_t)(s - out);
         if (*s == ',') s++;
+        while (len > 0 && (out[len-1] == ' ' || out[len-1] == '\t')) len--;
+        out[len] = '\0';
     }
     *pcur = s;
     return out;
 }
 
+// helper: consume the ',' after a #n channel number
+static bool expect_comma(basic_state_t* state, parser_state_t* parser_ptr) {
+    token_t comma = get_next_token(state, parser_ptr);
+    if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') {
+        set_error(state, ERR_SYNTAX, ", expected after file number");
+        return false;
+    }
+    return true;
+}
+
 int cmd_input_ex(basic_state_t* state, parser_state_t* parser_ptr) {
     bool have_prompt = false;
     bool prompt_with_question = false;
     char* prompt_text = NULL;
 
+    // INPUT #n, ... reads from a file channel: no prompt, and no retry on bad fields
+    input_reader_t* in = &state->input;
+    file_channel_t* file = NULL;
+
     // detect optional prompt; rewind if not a prompt
     uint16_t save_pos = parser_ptr->position;
     token_t tok = get_next_token(state, parser_ptr);
-    if (tok.type == TOKEN_STRING) {
+    if (tok.type == TOKEN_DELIMITER && tok.value.operator == '#') {
+        if (!(file = parse_file_channel(state, parser_ptr, false))) return -1;
+        if (!expect_comma(state, parser_ptr)) return -1;
+        in = &file->in;
+    } else if (tok.type == TOKEN_STRING) {
         prompt_text = tok.value.string;
         token_t sep = get_next_token(state, parser_ptr);
         if (sep.type == TOKEN_DELIMITER && (sep.value.operator == ';' || sep.value.operator == ',')) {
@@ -61,7 +75,7 @@ int cmd_input_ex(basic_state_t* state, parser_state_t* parser_ptr) {
         } else {
             parser_ptr->position = save_pos;
             parser_ptr->current_char = (parser_ptr->position < parser_ptr->length) ? parser_ptr->text[parser_ptr->position] : '\0';
-            if (prompt_text) { free(prompt_text); prompt_text = NULL; }
+            prompt_text = NULL;
         }
     } else {
         parser_ptr->position = save_pos;
@@ -69,45 +83,44 @@ int cmd_input_ex(basic_state_t* state, parser_state_t* parser_ptr) {
     }
 
     for (;;) {
-        if (have_prompt && prompt_text) {
-            if (prompt_with_question) printf("%s? ", prompt_text); else printf("%s", prompt_text);
-        } else {
-            printf("? ");
+        // prompts are only shown on a terminal; piped input is read silently
+        if (in->interactive) {
+            if (have_prompt && prompt_text) {
+                output_text(state, prompt_text);
+                if (prompt_with_question) output_text(state, "? ");
+            } else {
+                output_text(state, "? ");
+            }
         }
-        fflush(stdout);
 
-        if (!fgets(state->input_buffer, sizeof(state->input_buffer), stdin)) {
-            set_error(state, ERR_SYNTAX, "Input error");
-            if (prompt_text) free(prompt_text);
+        char* line = input_read_line(state, in, NULL);
+        if (!line) {
+            if (!has_error(state)) set_error(state, ERR_INPUT_PAST_END, NULL);
             return -1;
         }
-        size_t blen = strlen(state->input_buffer);
-        if (blen > 0 && state->input_buffer[blen-1] == '\n') state->input_buffer[blen-1] = '\0';
 
         parser_state_t pv = *parser_ptr;
-        char* cur = state->input_buffer;
+        char* cur = line;
         bool ok = true;
         while (ok) {
             token_t v = get_next_token(state, &pv);
             if (v.type != TOKEN_VARIABLE) { set_error(state, ERR_SYNTAX, "Variable expected in INPUT"); ok=false; break; }
             char* field = parse_field_quoted(&cur);
-            if (!field) { set_error(state, ERR_SYNTAX, "Input parse error"); ok=false; free(v.value.string); break; }
+            if (!field) { set_error(state, ERR_SYNTAX, "Input parse error"); ok=false; break; }
             bool is_str = strchr(v.value.string, '$') != NULL;
             variable_type_t vt = is_str ? VAR_STRING : VAR_NUMERIC;
             variable_t* var = create_variable(state, v.value.string, vt);
-            if (!var) { ok=false; free(field); free(v.value.string); break; }
+            if (!var) { ok=false; break; }
             if (is_str) {
-                if (var->value.str.data) free(var->value.str.data);
-                var->value.str.data = field;
-                var->value.str.length = (uint16_t)strlen(field);
+                char* data = heap_string(state, field, strlen(field));
+                if (!data) return -1;
+                variable_set_string(state, var, data);
             } else {
-                char* endp=NULL; double val = strtod(field,&endp);
+                const char* endp=NULL; double val = parse_decimal(field,&endp);
                 while (endp && *endp && isspace((unsigned char)*endp)) endp++;
                 if (!endp || *endp != '\0' || strlen(field)==0) { ok=false; }
                 else { var->value.num = double_to_numeric(val); }
-                free(field);
             }
-            free(v.value.string);
             if (!ok) break;
             uint16_t sp = pv.position; token_t d = get_next_token(state, &pv);
             if (d.type == TOKEN_DELIMITER && d.value.operator == ',') continue;
@@ -116,12 +129,88 @@ int cmd_input_ex(basic_state_t* state, parser_state_t* parser_ptr) {
         }
 
         if (ok) {
-            if (prompt_text) free(prompt_text);
             parser_ptr->position = pv.position;
             parser_ptr->current_char = (parser_ptr->position < parser_ptr->length) ? parser_ptr->text[parser_ptr->position] : '\0';
             return 0;
         }
-        printf("?Redo from start\n");
+        if (has_error(state)) return -1;
+        if (file) {
+            set_error(state, ERR_TYPE_MISMATCH, NULL);
+            return -1;
+        }
+        output_text(state, "?Redo from start\n");
+    }
+}
+
+// LINE INPUT ["prompt";] var$ and LINE INPUT #n, var$ - reads a whole line, commas and quotes included.
+// Unlike INPUT no "? " is shown; the prompt, if any, is shown on a terminal only.
+int cmd_line_input(basic_state_t* state, parser_state_t* parser_ptr) {
+    token_t tok = get_next_token(state, parser_ptr);
+    if (tok.type != TOKEN_KEYWORD || tok.value.keyword_id != KW_INPUT) {
+        set_error(state, ERR_SYNTAX, "INPUT expected after LINE");
+        return -1;
+    }
+
+    input_reader_t* in = &state->input;
+    const char* prompt_text = NULL;
+    tok = get_next_token(state, parser_ptr);
+    if (tok.type == TOKEN_DELIMITER && tok.value.operator == '#') {
+        file_channel_t* file = parse_file_channel(state, parser_ptr, false);
+        if (!file || !expect_comma(state, parser_ptr)) return -1;
+        in = &file->in;
+        tok = get_next_token(state, parser_ptr);
+    } else if (tok.type == TOKEN_STRING) {
+        prompt_text = tok.value.string;
+        token_t sep = get_next_token(state, parser_ptr);
+        if (sep.type != TOKEN_DELIMITER || (sep.value.operator != ';' && sep.value.operator != ',')) {
+            set_error(state, ERR_SYNTAX, "; expected after prompt");
+            return -1;
+        }
+        tok = get_next_token(state, parser_ptr);
+    }
+
+    if (tok.type != TOKEN_VARIABLE) {
+        set_error(state, ERR_SYNTAX, "Variable expected in LINE INPUT");
+        return -1;
+    }
+    if (!strchr(tok.value.string, '$')) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return -1;
+    }
+
+    // optional array subscripts
+    size_t indices[MAX_ARRAY_DIMENSIONS];
+    uint8_t index_count = 0;
+    uint16_t save = parser_ptr->position;
+    token_t paren = get_next_token(state, parser_ptr);
+    if (paren.type == TOKEN_DELIMITER && paren.value.operator == '(') {
+        if (parse_array_subscripts(state, parser_ptr, indices, &index_count) != 0) return -1;
+    } else {
+        parser_ptr->position = save;
+        parser_ptr->current_char = (parser_ptr->position < parser_ptr->length) ? parser_ptr->text[parser_ptr->position] : '\0';
+    }
+
+    if (prompt_text && in->interactive) output_text(state, prompt_text);
+
+    size_t length;
+    char* line = input_read_line(state, in, &length);
+    if (!line) {
+        if (!has_error(state)) set_error(state, ERR_INPUT_PAST_END, NULL);
+        return -1;
+    }
+
+    if (index_count > 0) {
+        eval_result_t value = {0};
+        value.type = 1;
+        value.value.str.data = line;
+        value.value.str.length = (uint32_t)length;
+        return assign_array_element(state, find_variable(state, tok.value.string), indices, index_count, value);
     }
+    variable_t* var = create_variable(state, tok.value.string, VAR_STRING);
+    if (!var) return -1;
+    char* data = heap_string(state, line, length);
+    if (!data) return -1;
+    variable_set_string(state, var, data);
+    return 0;
 }
 
@@ -5,19 +5,24 @@ int parse_line(basic_state_t* state, const char* line);
 int cmd_print(basic_state_t* state, parser_state_t* parser);
 int cmd_let(basic_state_t* state, parser_state_t* parser);
 
-void print_banner() {
-    printf("%s\n", BASIC_VERSION_STRING);
-    printf("READY\n");
+void print_banner(basic_state_t* state) {
+    output_printf(state, "%s\n", BASIC_VERSION_STRING);
+    output_text(state, "READY\n");
 }
 
-void print_prompt() {
-    printf("] ");
-    fflush(stdout);
+void print_prompt(basic_state_t* state) {
+    output_text(state, "] "); // 書き出しは入力を待つときに input_fill が行う
 }
 
-int main() {
+void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-l|--long-strings] [-b|--block-output] [-u|--line-output] [-a|--async-output]\n", program);
+}
+
+int main(int argc, char** argv) {
     basic_state_t state;
-    char input_line[MAX_LINE_LENGTH + 1];
+    char* command = NULL;           // 実行する行（長さの上限はない）
+    size_t command_capacity = 0;
+    bool async_output = false;
     
     // 初期化
     if (basic_init(&state) != 0) {
@@ -25,35 +30,66 @@ int main() {
         return 1;
     }
     
-    print_banner();
+    // コマンドラインオプション
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--long-strings") == 0) {
+            state.long_strings = true; // 文字列長の上限を MAX_LONG_STRING_LENGTH に拡張
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--block-output") == 0) {
+            state.output.flush = OUTPUT_FLUSH_BLOCK; // 出力はバッファが満杯か入力待ちのときだけ書き出す
+        } else if (strcmp(argv[i], "-u") == 0 || strcmp(argv[i], "--line-output") == 0) {
+            state.output.flush = OUTPUT_FLUSH_LINE;  // 出力は改行ごとに書き出す
+        } else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--async-output") == 0) {
+            async_output = true;                      // 出力は書き出しスレッドに任せる
+        } else {
+            print_usage(argv[0]);
+            basic_cleanup(&state);
+            return 1;
+        }
+    }
+    
+    if (async_output && output_start_writer(&state) != 0) {
+        fprintf(stderr, "Failed to start output writer, using synchronous output\n");
+    }
+    
+    print_banner(&state);
     
     // メインループ
     while (1) {
-        print_prompt();
+        print_prompt(&state);
         
         // 入力読み取り
-        if (!fgets(input_line, sizeof(input_line), stdin)) {
+        size_t len;
+        char* line = input_read_line(&state, &state.input, &len);
+        if (!line) {
             break; // EOF
         }
         
-        // 改行文字を削除
-        size_t len = strlen(input_line);
-        if (len > 0 && input_line[len - 1] == '\n') {
-            input_line[len - 1] = '\0';
-        }
-        
         // 空行チェック
-        if (strlen(input_line) == 0) {
+        if (len == 0) {
             continue;
         }
         
+        // 実行中の INPUT が入力領域を詰め直すので、行は複製してから実行する
+        if (len + 1 > command_capacity) {
+            char* grown = (char*)realloc(command, len + 1);
+            if (!grown) {
+                set_error(&state, ERR_OUT_OF_MEMORY, NULL);
+                print_error(&state);
+                clear_error(&state);
+                continue;
+            }
+            command = grown;
+            command_capacity = len + 1;
+        }
+        memcpy(command, line, len + 1);
+        
         // 終了コマンドチェック
-        if (strcmp(input_line, "QUIT") == 0 || strcmp(input_line, "EXIT") == 0) {
+        if (strcmp(command, "QUIT") == 0 || strcmp(command, "EXIT") == 0) {
             break;
         }
         
         // 行を解析・実行
-        parse_line(&state, input_line);
+        parse_line(&state, command);
         
         // エラーチェック
         if (has_error(&state)) {
@@ -62,9 +98,10 @@ int main() {
         }
     }
     
-    // クリーンアップ
+    // クリーンアップ（残りの出力もここで書き出す）
+    output_text(&state, "BYE\n");
     basic_cleanup(&state);
-    printf("BYE\n");
+    free(command);
     
     return 0;
 }
@@ -0,0 +1,242 @@
+#include "basic.h"
+
+// 連想配列（文字列をキーとする表）
+//
+//   DIM M AS MAP, N$ AS MAP    数値・文字列の値を持つ連想配列を作る
+//   M("key") = 5               キーがなければ追加、あれば上書き
+//   PRINT M("key")             未登録のキーは 0 / 空文字列
+//   HASKEY(M, "key")           登録済みなら -1、なければ 0
+//   KEYS(M)                    登録されているキーの数
+//   KEY$(M, I)                 I 番目（0から、追加順）のキー
+//
+// 要素は追加順に entries へ並べ、索引表（オープンアドレス法、線形探査）に位置を持つ。
+// 索引表は使用率が 1/2 を超えたら倍に広げる。要素の削除はない。
+
+#define MAP_INITIAL_CAPACITY 16
+
+// キーのハッシュ（FNV-1a）
+static uint64_t map_hash(const char* key, uint32_t length) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (uint32_t i = 0; i < length; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static bool is_map(const variable_t* var) {
+    return var && (var->type == VAR_MAP_NUMERIC || var->type == VAR_MAP_STRING);
+}
+
+variable_t* create_map(basic_state_t* state, const char* name) {
+    map_table_t* map = (map_table_t*)arena_alloc(&state->heap, sizeof(map_table_t));
+    map_entry_t* entries = (map_entry_t*)arena_array_alloc(&state->heap, MAP_INITIAL_CAPACITY, sizeof(map_entry_t));
+    uint32_t* index = (uint32_t*)arena_array_alloc(&state->heap, 2 * MAP_INITIAL_CAPACITY, sizeof(uint32_t));
+    if (!map || !entries || !index) {
+        arena_block_free(&state->heap, entries);
+        arena_block_free(&state->heap, index);
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    map->entries = entries;
+    map->count = 0;
+    map->entry_capacity = MAP_INITIAL_CAPACITY;
+    map->index = index;
+    map->index_capacity = 2 * MAP_INITIAL_CAPACITY;
+
+    bool is_string = strchr(name, '$') != NULL;
+    variable_t* var = create_variable(state, name, is_string ? VAR_MAP_STRING : VAR_MAP_NUMERIC);
+    if (!var) {
+        arena_block_free(&state->heap, entries);
+        arena_block_free(&state->heap, index);
+        return NULL;
+    }
+    var->value.map = map;
+    return var;
+}
+
+// キーの要素（なければ NULL）
+static map_entry_t* map_find(const map_table_t* map, const char* key, uint32_t length, uint64_t hash) {
+    size_t mask = map->index_capacity - 1;
+    for (size_t i = (size_t)hash & mask; map->index[i] != 0; i = (i + 1) & mask) {
+        map_entry_t* entry = &map->entries[map->index[i] - 1];
+        if (entry->hash == hash && entry->key_length == length && memcmp(entry->key, key, length) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// 要素と索引表の拡張（要素は位置が変わらないので、索引表は位置をそのまま入れ直す）
+static int map_reserve(basic_state_t* state, map_table_t* map) {
+    if (map->count < map->entry_capacity) return 0;
+    if (map->entry_capacity >= UINT32_MAX / 2) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    size_t entry_capacity = map->entry_capacity * 2;
+    size_t index_capacity = entry_capacity * 2;
+    map_entry_t* entries = (map_entry_t*)arena_array_alloc(&state->heap, entry_capacity, sizeof(map_entry_t));
+    uint32_t* index = (uint32_t*)arena_array_alloc(&state->heap, index_capacity, sizeof(uint32_t));
+    if (!entries || !index) {
+        arena_block_free(&state->heap, entries);
+        arena_block_free(&state->heap, index);
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    memcpy(entries, map->entries, map->count * sizeof(map_entry_t));
+    for (size_t e = 0; e < map->count; e++) {
+        size_t i = (size_t)entries[e].hash & (index_capacity - 1);
+        while (index[i] != 0) i = (i + 1) & (index_capacity - 1);
+        index[i] = (uint32_t)(e + 1);
+    }
+    arena_block_free(&state->heap, map->entries);
+    arena_block_free(&state->heap, map->index);
+    map->entries = entries;
+    map->entry_capacity = entry_capacity;
+    map->index = index;
+    map->index_capacity = index_capacity;
+    return 0;
+}
+
+// キーの要素を取得、なければ値 0（空文字列）で追加
+static map_entry_t* map_insert(basic_state_t* state, map_table_t* map, const char* key, uint32_t length) {
+    uint64_t hash = map_hash(key, length);
+    map_entry_t* entry = map_find(map, key, length, hash);
+    if (entry) return entry;
+
+    char* copy = arena_block_strndup(&state->heap, key, length);
+    if (!copy || map_reserve(state, map) != 0) {
+        arena_block_free(&state->heap, copy);
+        if (!has_error(state)) set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return NULL;
+    }
+    entry = &map->entries[map->count];
+    memset(entry, 0, sizeof(map_entry_t));
+    entry->key = copy;
+    entry->key_length = length;
+    entry->hash = hash;
+
+    size_t mask = map->index_capacity - 1;
+    size_t i = (size_t)hash & mask;
+    while (map->index[i] != 0) i = (i + 1) & mask;
+    map->index[i] = (uint32_t)(++map->count);
+    return entry;
+}
+
+// キーの解析 - 開き括弧の直後から閉じ括弧までを読む
+int parse_map_key(basic_state_t* state, parser_state_t* parser, const char** key, uint32_t* key_length) {
+    eval_result_t k = evaluate_expression(state, parser);
+    if (has_error(state)) return -1;
+    if (k.type != 1) {
+        set_error(state, ERR_TYPE_MISMATCH, "String key expected");
+        return -1;
+    }
+    token_t close = get_next_token(state, parser);
+    if (close.type != TOKEN_DELIMITER || close.value.operator != ')') {
+        set_error(state, ERR_SYNTAX, ") expected");
+        return -1;
+    }
+    *key = k.value.str.data ? k.value.str.data : "";
+    *key_length = (uint32_t)strlen(*key);
+    return 0;
+}
+
+// 要素の参照（未登録のキーは 0 / 空文字列）
+eval_result_t access_map_element(basic_state_t* state, variable_t* var, const char* key, uint32_t key_length) {
+    eval_result_t result = {0};
+    const map_entry_t* entry = map_find(var->value.map, key, key_length, map_hash(key, key_length));
+    if (var->type == VAR_MAP_NUMERIC) {
+        result.type = 0;
+        result.value.num = entry ? entry->value.num : double_to_numeric(0.0);
+    } else {
+        const char* text = (entry && entry->value.str) ? entry->value.str : "";
+        result.type = 1;
+        result.value.str.length = (uint32_t)strlen(text);
+        result.value.str.data = scratch_string(state, text, result.value.str.length);
+        if (!result.value.str.data) result.value.str.length = 0;
+    }
+    return result;
+}
+
+// 要素への代入
+int assign_map_element(basic_state_t* state, variable_t* var, const char* key, uint32_t key_length, eval_result_t value) {
+    bool is_string = (var->type == VAR_MAP_STRING);
+    if (value.type != (is_string ? 1 : 0)) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return -1;
+    }
+    char* text = NULL;
+    if (is_string) {
+        // 一時領域の値を表用に複製
+        const char* src = value.value.str.data;
+        text = heap_string(state, src, src ? strlen(src) : 0);
+        if (!text) return -1;
+    }
+    map_entry_t* entry = map_insert(state, var->value.map, key, key_length);
+    if (!entry) {
+        arena_block_free(&state->heap, text);
+        return -1;
+    }
+    if (is_string) {
+        arena_block_free(&state->heap, entry->value.str);
+        entry->value.str = text;
+    } else {
+        entry->value.num = value.value.num;
+    }
+    return 0;
+}
+
+// HASKEY(M, k$) KEYS(M) KEY$(M, I) - 開き括弧の直後から呼ばれ、閉じ括弧は呼び出し側で読む
+eval_result_t func_map(basic_state_t* state, parser_state_t* parser, uint8_t function_id) {
+    eval_result_t result = {0};
+    token_t name = get_next_token(state, parser);
+    variable_t* var = (name.type == TOKEN_VARIABLE) ? find_variable(state, name.value.string) : NULL;
+    if (!is_map(var)) {
+        set_error(state, ERR_TYPE_MISMATCH, "Map expected");
+        return result;
+    }
+    map_table_t* map = var->value.map;
+
+    if (function_id == KW_KEYS) {
+        result.type = 0;
+        result.value.num = double_to_numeric((double)map->count);
+        return result;
+    }
+
+    token_t comma = get_next_token(state, parser);
+    if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') {
+        set_error(state, ERR_SYNTAX, ", expected");
+        return result;
+    }
+    eval_result_t arg = evaluate_expression(state, parser);
+    if (has_error(state)) return result;
+
+    if (function_id == KW_HASKEY) {
+        if (arg.type != 1) {
+            set_error(state, ERR_TYPE_MISMATCH, "String key expected");
+            return result;
+        }
+        const char* key = arg.value.str.data ? arg.value.str.data : "";
+        uint32_t length = (uint32_t)strlen(key);
+        result.type = 0;
+        result.value.num = double_to_numeric(map_find(map, key, length, map_hash(key, length)) ? -1.0 : 0.0);
+        return result;
+    }
+
+    // KEY$
+    if (arg.type != 0) {
+        set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected");
+        return result;
+    }
+    double position = trunc(numeric_to_double(arg.value.num));
+    if (!(position >= 0) || position >= (double)map->count) {
+        set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, NULL);
+        return result;
+    }
+    const map_entry_t* entry = &map->entries[(size_t)position];
+    result.type = 1;
+    result.value.str.data = scratch_string(state, entry->key, entry->key_length);
+    result.value.str.length = result.value.str.data ? entry->key_length : 0;
+    return result;
+}
@@ -0,0 +1,407 @@
+#include "basic.h"
+
+// 外部関数の宣言
+extern numeric_value_t func_sgn(numeric_value_t x);
+extern numeric_value_t func_int(numeric_value_t x);
+extern numeric_value_t func_abs(numeric_value_t x);
+extern numeric_value_t func_sqr(numeric_value_t x);
+extern numeric_value_t func_log(numeric_value_t x);
+extern numeric_value_t func_exp(numeric_value_t x);
+extern numeric_value_t func_cos(numeric_value_t x);
+extern numeric_value_t func_sin(numeric_value_t x);
+extern numeric_value_t func_tan(numeric_value_t x);
+extern numeric_value_t func_atn(numeric_value_t x);
+
+// MAT文（Dartmouth BASIC 形式の行列演算）
+//
+//   MAT C = A + B / A - B / A * B / A
+//   MAT C = (k) * A
+//   MAT C = TRN(A)
+//   MAT C = SIN(A)        要素ごとの関数（SGN INT ABS SQR LOG EXP COS SIN TAN ATN）
+//   MAT READ A, B$, ...
+//   MAT PRINT A, B; ...
+//
+// 配列は0ベースなので、DIM A(2,3) は添字0を含む 3×4 の行列として扱う。
+// 結果の配列が未定義なら自動的に作成し、定義済みなら同じ形であること。
+
+typedef numeric_value_t (*element_func_t)(numeric_value_t);
+
+// 配列の要素を double 列として参照
+static double* array_values(variable_t* var) {
+    return (double*)var->value.array.data;
+}
+
+static bool is_delimiter(token_t token, char ch) {
+    return token.type == TOKEN_DELIMITER && token.value.operator == ch;
+}
+
+static bool same_shape(const variable_t* a, const variable_t* b) {
+    if (a->value.array.dim_count != b->value.array.dim_count) return false;
+    for (uint8_t i = 0; i < a->value.array.dim_count; i++) {
+        if (a->value.array.dimensions[i] != b->value.array.dimensions[i]) return false;
+    }
+    return true;
+}
+
+// 行列（2次元配列）の行数・列数
+static bool matrix_shape(basic_state_t* state, const variable_t* var, size_t* rows, size_t* cols) {
+    if (var->value.array.dim_count != 2) {
+        set_error(state, ERR_SYNTAX, "Two-dimensional array expected");
+        return false;
+    }
+    *rows = var->value.array.dimensions[0] + 1;
+    *cols = var->value.array.dimensions[1] + 1;
+    return true;
+}
+
+// 結果配列の取得（未定義なら作成、定義済みなら形を確認）
+static variable_t* result_array(basic_state_t* state, const char* name,
+                                const size_t* dimensions, uint8_t dim_count) {
+    if (strchr(name, '$')) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return NULL;
+    }
+    variable_t* var = find_variable(state, name);
+    if (!var) return create_array(state, name, dimensions, dim_count);
+
+    if (var->type != VAR_ARRAY_NUMERIC || var->value.array.dim_count != dim_count) {
+        set_error(state, ERR_REDIMENSIONED_ARRAY, NULL);
+        return NULL;
+    }
+    if (var->value.array.storage == ARRAY_STORAGE_SPARSE) {
+        set_error(state, ERR_TYPE_MISMATCH, "Sparse array not allowed here");
+        return NULL;
+    }
+    for (uint8_t i = 0; i < dim_count; i++) {
+        if (var->value.array.dimensions[i] != dimensions[i]) {
+            set_error(state, ERR_REDIMENSIONED_ARRAY, NULL);
+            return NULL;
+        }
+    }
+    return var;
+}
+
+// 結果の書き込み先（オペランドと重なる場合は一時領域）
+static double* output_buffer(basic_state_t* state, variable_t* dest, const variable_t* a, const variable_t* b) {
+    if (dest != a && dest != b) return array_values(dest);
+    size_t total = dest->value.array.total_elements;
+    double* tmp = (double*)arena_alloc(&state->scratch, total * sizeof(double));
+    if (!tmp) set_error(state, ERR_OUT_OF_MEMORY, NULL);
+    return tmp;
+}
+
+static void commit_output(variable_t* dest, double* out) {
+    double* values = array_values(dest);
+    if (out != values) memcpy(values, out, dest->value.array.total_elements * sizeof(double));
+}
+
+static element_func_t element_function(uint8_t keyword_id) {
+    switch (keyword_id) {
+        case 0xAE: return func_sgn;
+        case 0xAF: return func_int;
+        case 0xB0: return func_abs;
+        case 0xB4: return func_sqr;
+        case 0xB6: return func_log;
+        case 0xB7: return func_exp;
+        case 0xB8: return func_cos;
+        case 0xB9: return func_sin;
+        case 0xBA: return func_tan;
+        case 0xBB: return func_atn;
+        default: return NULL;
+    }
+}
+
+// (配列) の形の引数を読む
+static variable_t* parse_array_argument(basic_state_t* state, parser_state_t* parser) {
+    if (!is_delimiter(get_next_token(state, parser), '(')) {
+        set_error(state, ERR_SYNTAX, "( expected");
+        return NULL;
+    }
+    variable_t* var = resolve_array(state, get_next_token(state, parser), true);
+    if (!var) return NULL;
+    if (!is_delimiter(get_next_token(state, parser), ')')) {
+        set_error(state, ERR_SYNTAX, ") expected");
+        return NULL;
+    }
+    return var;
+}
+
+// MAT C = ...
+static int mat_assign(basic_state_t* state, parser_state_t* parser, const char* dest_name) {
+    token_t eq = get_next_token(state, parser);
+    if (eq.type != TOKEN_OPERATOR || eq.value.operator != '=') {
+        set_error(state, ERR_SYNTAX, "= expected");
+        return -1;
+    }
+
+    token_t first = get_next_token(state, parser);
+
+    // (k) * A
+    if (is_delimiter(first, '(')) {
+        eval_result_t k = evaluate_expression(state, parser);
+        if (has_error(state)) return -1;
+        if (k.type != 0) { set_error(state, ERR_TYPE_MISMATCH, NULL); return -1; }
+        if (!is_delimiter(get_next_token(state, parser), ')')) { set_error(state, ERR_SYNTAX, ") expected"); return -1; }
+        token_t star = get_next_token(state, parser);
+        if (star.type != TOKEN_OPERATOR || star.value.operator != '*') { set_error(state, ERR_SYNTAX, "* expected"); return -1; }
+        variable_t* a = resolve_array(state, get_next_token(state, parser), true);
+        if (!a) return -1;
+        variable_t* dest = result_array(state, dest_name, a->value.array.dimensions, a->value.array.dim_count);
+        if (!dest) return -1;
+        vec_scale(array_values(dest), array_values(a), numeric_to_double(k.value.num), a->value.array.total_elements);
+        return 0;
+    }
+
+    // SIN(A) など要素ごとの関数
+    if (first.type == TOKEN_KEYWORD) {
+        element_func_t fn = element_function(first.value.keyword_id);
+        if (!fn) { set_error(state, ERR_SYNTAX, "Matrix function expected"); return -1; }
+        variable_t* a = parse_array_argument(state, parser);
+        if (!a) return -1;
+        variable_t* dest = result_array(state, dest_name, a->value.array.dimensions, a->value.array.dim_count);
+        if (!dest) return -1;
+        numeric_value_t* src = (numeric_value_t*)a->value.array.data;
+        numeric_value_t* dst = (numeric_value_t*)dest->value.array.data;
+        for (size_t i = 0; i < a->value.array.total_elements; i++) {
+            dst[i] = fn(src[i]);
+        }
+        return 0;
+    }
+
+    // TRN(A)
+    uint16_t after_first = parser->position;
+    if (first.type == TOKEN_VARIABLE && strcmp(first.value.string, "TRN") == 0 &&
+        is_delimiter(get_next_token(state, parser), '(')) {
+        parser_rewind(parser, after_first);
+        variable_t* a = parse_array_argument(state, parser);
+        if (!a) return -1;
+        size_t rows, cols;
+        if (!matrix_shape(state, a, &rows, &cols)) return -1;
+        size_t dims[2] = { a->value.array.dimensions[1], a->value.array.dimensions[0] };
+        variable_t* dest = result_array(state, dest_name, dims, 2);
+        if (!dest) return -1;
+        double* out = output_buffer(state, dest, a, NULL);
+        if (!out) return -1;
+        mat_transpose(out, array_values(a), rows, cols);
+        commit_output(dest, out);
+        return 0;
+    }
+    parser_rewind(parser, after_first);
+
+    // A [op B]
+    variable_t* a = resolve_array(state, first, true);
+    if (!a) return -1;
+
+    uint16_t save = parser->position;
+    token_t op = get_next_token(state, parser);
+    if (op.type != TOKEN_OPERATOR || (op.value.operator != '+' && op.value.operator != '-' && op.value.operator != '*')) {
+        // MAT C = A（複写）
+        parser_rewind(parser, save);
+        variable_t* dest = result_array(state, dest_name, a->value.array.dimensions, a->value.array.dim_count);
+        if (!dest) return -1;
+        if (dest != a) {
+            memcpy(array_values(dest), array_values(a), a->value.array.total_elements * sizeof(double));
+        }
+        return 0;
+    }
+
+    variable_t* b = resolve_array(state, get_next_token(state, parser), true);
+    if (!b) return -1;
+
+    if (op.value.operator == '*') {
+        size_t m, n, n2, p;
+        if (!matrix_shape(state, a, &m, &n) || !matrix_shape(state, b, &n2, &p)) return -1;
+        if (n != n2) {
+            set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, "Matrix dimensions do not conform");
+            return -1;
+        }
+        size_t dims[2] = { a->value.array.dimensions[0], b->value.array.dimensions[1] };
+        variable_t* dest = result_array(state, dest_name, dims, 2);
+        if (!dest) return -1;
+        double* out = output_buffer(state, dest, a, b);
+        if (!out) return -1;
+        mat_multiply(out, array_values(a), array_values(b), m, n, p);
+        commit_output(dest, out);
+        return 0;
+    }
+
+    if (!same_shape(a, b)) {
+        set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, "Matrix dimensions do not conform");
+        return -1;
+    }
+    variable_t* dest = result_array(state, dest_name, a->value.array.dimensions, a->value.array.dim_count);
+    if (!dest) return -1;
+    if (op.value.operator == '+') {
+        vec_add(array_values(dest), array_values(a), array_values(b), a->value.array.total_elements);
+    } else {
+        vec_sub(array_values(dest), array_values(a), array_values(b), a->value.array.total_elements);
+    }
+    return 0;
+}
+
+// MAT READ A, B$, ... - DATA から全要素を順に読む
+static int mat_read(basic_state_t* state, parser_state_t* parser) {
+    while (true) {
+        variable_t* var = resolve_array(state, get_next_token(state, parser), false);
+        if (!var) return -1;
+
+        size_t total = var->value.array.total_elements;
+        for (size_t i = 0; i < total; i++) {
+            const data_item_t* item = read_data_item(state);
+            if (!item) return -1;
+            if (var->type == VAR_ARRAY_NUMERIC) {
+                ((numeric_value_t*)var->value.array.data)[i] = data_item_number(item);
+            } else {
+                const char* text = data_item_text(state, item);
+                if (!text || string_array_set(state, var, i, text, strlen(text)) != 0) return -1;
+            }
+        }
+
+        uint16_t save = parser->position;
+        if (is_delimiter(get_next_token(state, parser), ',')) continue;
+        parser_rewind(parser, save);
+        return 0;
+    }
+}
+
+static void mat_put_text(basic_state_t* state, const char* text) {
+    output_text(state, text);
+    state->trmpos = (uint8_t)((state->trmpos + (unsigned)strlen(text)) % 255);
+}
+
+static void mat_put_spaces(basic_state_t* state, int count) {
+    output_spaces(state, count);
+    state->trmpos = (uint8_t)((state->trmpos + (unsigned)count) % 255);
+}
+
+static void mat_newline(basic_state_t* state) {
+    output_char(state, '\n');
+    state->trmpos = 0;
+}
+
+// 配列1つの表示（2次元は1行ずつ、それ以外は1行に並べる）
+static void mat_print_array(basic_state_t* state, variable_t* var, bool packed) {
+    const int zone = 14; // PRINT と同じ区切り幅
+    size_t total = var->value.array.total_elements;
+    size_t cols = (var->value.array.dim_count == 2) ? var->value.array.dimensions[1] + 1 : total;
+
+    for (size_t i = 0; i < total; i++) {
+        if (i % cols != 0) {
+            if (packed) {
+                mat_put_spaces(state, 1);
+            } else {
+                int spaces = zone - (state->trmpos % zone);
+                mat_put_spaces(state, spaces);
+            }
+        }
+        if (var->type == VAR_ARRAY_NUMERIC) {
+            char buf[NUMBER_FORMAT_SIZE];
+            format_number(double_to_numeric(array_values(var)[i]), buf);
+            mat_put_text(state, buf);
+        } else {
+            mat_put_text(state, string_array_get(var, i, NULL));
+        }
+        if (i % cols == cols - 1) mat_newline(state);
+    }
+}
+
+// MAT PRINT A, B; ... - 区切りが ; なら詰めて、, なら区切り幅で表示
+static int mat_print(basic_state_t* state, parser_state_t* parser) {
+    bool first = true;
+    while (true) {
+        variable_t* var = resolve_array(state, get_next_token(state, parser), false);
+        if (!var) return -1;
+
+        uint16_t save = parser->position;
+        token_t sep = get_next_token(state, parser);
+        bool packed = is_delimiter(sep, ';');
+
+        if (!first) mat_newline(state);
+        if (state->trmpos != 0) mat_newline(state);
+        mat_print_array(state, var, packed);
+        first = false;
+
+        if (is_delimiter(sep, ',') || packed) {
+            uint16_t after = parser->position;
+            token_t next = get_next_token(state, parser);
+            parser_rewind(parser, after);
+            if (next.type == TOKEN_VARIABLE) continue;
+            return 0;
+        }
+        parser_rewind(parser, save);
+        return 0;
+    }
+}
+
+// MAT文の実装
+int cmd_mat(basic_state_t* state, parser_state_t* parser) {
+    token_t token = get_next_token(state, parser);
+    if (token.type == TOKEN_KEYWORD && token.value.keyword_id == KW_READ) {
+        return mat_read(state, parser);
+    }
+    if (token.type == TOKEN_KEYWORD && token.value.keyword_id == KW_PRINT) {
+        return mat_print(state, parser);
+    }
+    if (token.type != TOKEN_VARIABLE) {
+        set_error(state, ERR_SYNTAX, "MAT READ, MAT PRINT or array expected");
+        return -1;
+    }
+    return mat_assign(state, parser, token.value.string);
+}
+
+// 配列の集約関数 SUM(A) MIN(A) MAX(A) MEAN(A) DOT(A,B) COUNT(A,x)
+// 開き括弧の直後から呼ばれ、閉じ括弧は呼び出し側で読む
+eval_result_t func_array_aggregate(basic_state_t* state, parser_state_t* parser, uint8_t function_id) {
+    eval_result_t result = {0};
+    variable_t* a = resolve_array(state, get_next_token(state, parser), true);
+    if (!a) return result;
+
+    const double* values = array_values(a);
+    size_t n = a->value.array.total_elements;
+    result.type = 0;
+
+    switch (function_id) {
+        case KW_SUM:
+            result.value.num = double_to_numeric(vec_sum(values, n));
+            break;
+        case KW_MEAN:
+            result.value.num = double_to_numeric(vec_sum(values, n) / (double)n);
+            break;
+        case KW_MIN:
+        case KW_MAX: {
+            double mn, mx;
+            vec_minmax(values, n, &mn, &mx);
+            result.value.num = double_to_numeric(function_id == KW_MIN ? mn : mx);
+            break;
+        }
+        case KW_DOT: {
+            if (!is_delimiter(get_next_token(state, parser), ',')) {
+                set_error(state, ERR_SYNTAX, ", expected");
+                return result;
+            }
+            variable_t* b = resolve_array(state, get_next_token(state, parser), true);
+            if (!b) return result;
+            if (!same_shape(a, b)) {
+                set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, "Array dimensions do not conform");
+                return result;
+            }
+            result.value.num = double_to_numeric(vec_dot(values, array_values(b), n));
+            break;
+        }
+        case KW_COUNT: {
+            if (!is_delimiter(get_next_token(state, parser), ',')) {
+                set_error(state, ERR_SYNTAX, ", expected");
+                return result;
+            }
+            eval_result_t x = evaluate_expression(state, parser);
+            if (has_error(state)) return result;
+            if (x.type != 0) {
+                set_error(state, ERR_TYPE_MISMATCH, "Numeric argument expected");
+                return result;
+            }
+            result.value.num = double_to_numeric((double)vec_count_equal(values, numeric_to_double(x.value.num), n));
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,239 @@
+#include "basic.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+// 標準出力のバッファ
+//
+// PRINT などの出力はいったんバッファに溜め、まとめて write する。
+// 書き出すのはバッファが満杯になったとき、入力を読む前（INPUT/GET/プロンプト）、
+// END/STOP と終了時、それに行単位モードなら改行を書いたとき。
+// 既定は端末なら行単位、パイプやファイルならブロック単位。
+//
+// 非同期モード（output_start_writer）では書き出しをリングバッファへのコピーに置き換え、
+// 専用のスレッドが ring から write する。解釈側が待つのは ring が満杯のときと、
+// 入力の前などで書き出しの完了を待つときだけ。ring は単一生産者・単一消費者で、
+// head/tail の原子的な読み書きだけで受け渡し、mutex は眠る・起こすためにだけ使う。
+
+void output_init(output_t* out, int fd) {
+    out->fd = fd;
+    out->flush = isatty(fd) ? OUTPUT_FLUSH_LINE : OUTPUT_FLUSH_BLOCK;
+    out->ring = NULL;
+    out->used = 0;
+    out->failed = false;
+}
+
+// 書けなかったら false（残りは捨てる）
+static bool write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// ---- リングバッファ ----
+
+// tail が goal に達するまで待つ（解釈側）
+static void ring_wait(output_t* out, size_t goal) {
+    pthread_mutex_lock(&out->lock);
+    __atomic_store_n(&out->producer_waiting, true, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&out->tail, __ATOMIC_SEQ_CST) < goal) {
+        pthread_cond_wait(&out->drained, &out->lock);
+    }
+    __atomic_store_n(&out->producer_waiting, false, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&out->lock);
+}
+
+// ring へ追加（解釈側、満杯なら空くまで待つ）
+static void ring_push(output_t* out, const char* data, size_t length) {
+    const size_t mask = OUTPUT_RING_SIZE - 1;
+    while (length > 0) {
+        size_t head = out->head;
+        size_t tail = __atomic_load_n(&out->tail, __ATOMIC_ACQUIRE);
+        size_t space = OUTPUT_RING_SIZE - (head - tail);
+        if (space == 0) {
+            ring_wait(out, head - OUTPUT_RING_SIZE + 1);
+            continue;
+        }
+        size_t n = length < space ? length : space;
+        size_t offset = head & mask;
+        size_t first = n < OUTPUT_RING_SIZE - offset ? n : OUTPUT_RING_SIZE - offset;
+        memcpy(out->ring + offset, data, first);
+        memcpy(out->ring, data + first, n - first);
+        __atomic_store_n(&out->head, head + n, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&out->writer_waiting, __ATOMIC_SEQ_CST)) {
+            pthread_mutex_lock(&out->lock);
+            pthread_cond_signal(&out->ready);
+            pthread_mutex_unlock(&out->lock);
+        }
+        data += n;
+        length -= n;
+    }
+}
+
+// 書き出しスレッド - ring の内容を連続した区間ごとに write する
+static void* writer_main(void* arg) {
+    output_t* out = (output_t*)arg;
+    const size_t mask = OUTPUT_RING_SIZE - 1;
+    while (true) {
+        size_t tail = out->tail;
+        size_t head = __atomic_load_n(&out->head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (__atomic_load_n(&out->stop, __ATOMIC_ACQUIRE)) break;
+            pthread_mutex_lock(&out->lock);
+            __atomic_store_n(&out->writer_waiting, true, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&out->head, __ATOMIC_SEQ_CST) == tail &&
+                   !__atomic_load_n(&out->stop, __ATOMIC_SEQ_CST)) {
+                pthread_cond_wait(&out->ready, &out->lock);
+            }
+            __atomic_store_n(&out->writer_waiting, false, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&out->lock);
+            continue;
+        }
+        size_t offset = tail & mask;
+        size_t n = head - tail;
+        if (n > OUTPUT_RING_SIZE - offset) n = OUTPUT_RING_SIZE - offset;
+        if (!write_all(out->fd, out->ring + offset, n)) out->failed = true;
+        __atomic_store_n(&out->tail, tail + n, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&out->producer_waiting, __ATOMIC_SEQ_CST)) {
+            pthread_mutex_lock(&out->lock);
+            pthread_cond_signal(&out->drained);
+            pthread_mutex_unlock(&out->lock);
+        }
+    }
+    return NULL;
+}
+
+// 非同期モードの開始（失敗したら同期のまま -1）
+int output_start_writer(basic_state_t* state) {
+    output_t* out = &state->output;
+    if (out->ring) return 0;
+    char* ring = (char*)malloc(OUTPUT_RING_SIZE);
+    if (!ring) return -1;
+    output_flush(state);
+    out->head = out->tail = 0;
+    out->stop = out->writer_waiting = out->producer_waiting = false;
+    pthread_mutex_init(&out->lock, NULL);
+    pthread_cond_init(&out->ready, NULL);
+    pthread_cond_init(&out->drained, NULL);
+    out->ring = ring;
+    if (pthread_create(&out->thread, NULL, writer_main, out) != 0) {
+        out->ring = NULL;
+        free(ring);
+        pthread_cond_destroy(&out->drained);
+        pthread_cond_destroy(&out->ready);
+        pthread_mutex_destroy(&out->lock);
+        return -1;
+    }
+    return 0;
+}
+
+// 非同期モードの終了（残りを書き出してからスレッドを止める）
+void output_stop_writer(basic_state_t* state) {
+    output_t* out = &state->output;
+    if (!out->ring) return;
+    output_flush(state);
+    pthread_mutex_lock(&out->lock);
+    __atomic_store_n(&out->stop, true, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&out->ready);
+    pthread_mutex_unlock(&out->lock);
+    pthread_join(out->thread, NULL);
+    pthread_cond_destroy(&out->drained);
+    pthread_cond_destroy(&out->ready);
+    pthread_mutex_destroy(&out->lock);
+    free(out->ring);
+    out->ring = NULL;
+}
+
+// ---- バッファ ----
+// output_put などは任意の output_t（標準出力とファイルチャネル）に、
+// output_write などは標準出力に書く
+
+// バッファの内容を送り出す（非同期モードでは ring に移すだけ）
+static void output_emit(output_t* out, const char* data, size_t length) {
+    if (out->ring) ring_push(out, data, length);
+    else if (!write_all(out->fd, data, length)) out->failed = true;
+}
+
+// バッファを書き出す（非同期モードではスレッドが書き終えるまで待つ）
+void output_drain(output_t* out) {
+    if (out->used > 0) {
+        output_emit(out, out->buffer, out->used);
+        out->used = 0;
+    }
+    if (out->ring) ring_wait(out, out->head);
+}
+
+void output_put(output_t* out, const char* data, size_t length) {
+    if (length > OUTPUT_BUFFER_SIZE - out->used) {
+        output_emit(out, out->buffer, out->used);
+        out->used = 0;
+        if (length >= OUTPUT_BUFFER_SIZE) {
+            // バッファより大きければ直接送る
+            output_emit(out, data, length);
+            return;
+        }
+    }
+    memcpy(out->buffer + out->used, data, length);
+    out->used += length;
+    if (out->flush == OUTPUT_FLUSH_LINE && memchr(data, '\n', length)) {
+        output_emit(out, out->buffer, out->used);
+        out->used = 0;
+    }
+}
+
+void output_put_spaces(output_t* out, int count) {
+    static const char spaces[] = "                                ";
+    while (count > 0) {
+        int n = count < (int)sizeof(spaces) - 1 ? count : (int)sizeof(spaces) - 1;
+        output_put(out, spaces, (size_t)n);
+        count -= n;
+    }
+}
+
+void output_flush(basic_state_t* state) {
+    output_drain(&state->output);
+}
+
+void output_write(basic_state_t* state, const char* data, size_t length) {
+    output_put(&state->output, data, length);
+}
+
+void output_text(basic_state_t* state, const char* text) {
+    output_put(&state->output, text, strlen(text));
+}
+
+void output_char(basic_state_t* state, char c) {
+    output_put(&state->output, &c, 1);
+}
+
+void output_spaces(basic_state_t* state, int count) {
+    output_put_spaces(&state->output, count);
+}
+
+void output_printf(basic_state_t* state, const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0) return;
+    if ((size_t)length < sizeof(text)) {
+        output_write(state, text, (size_t)length);
+        return;
+    }
+    // 長い出力
+    char* long_text = (char*)malloc((size_t)length + 1);
+    if (!long_text) return;
+    va_start(args, format);
+    vsnprintf(long_text, (size_t)length + 1, format, args);
+    va_end(args);
+    output_write(state, long_text, (size_t)length);
+    free(long_text);
+}
@@ -1,5 +1,6 @@
 #include "basic.h"
 #include <ctype.h>
+#include <strings.h>
 
 // 外部関数の宣言
 numeric_value_t double_to_numeric(double d);
@@ -8,12 +9,20 @@ variable_t* create_variable(basic_state_t* state, const char* name, variable_typ
 int add_program_line(basic_state_t* state, uint16_t line_number, const char* text);
 
 // BASICキーワード定義
+// 拡張キーワードは予約語にせず、使われ方がその形のときだけキーワードとする
+// （それ以外では同じ名前の変数として読むので、元のBASICのプログラムはそのまま動く）
+typedef enum {
+    KEYWORD_RESERVED = 0,   // 元のBASICのキーワード（常にキーワード）
+    KEYWORD_STATEMENT,      // 文の先頭にあり、代入の = が続かないとき
+    KEYWORD_FUNCTION        // 直後に ( が続くとき
+} keyword_use_t;
+
 typedef struct {
     const char* name;
     uint8_t id;
 } keyword_t;
 
-// キーワードテーブル
+// キーワードテーブル（拡張キーワードのIDは basic.h の KW_*）
 static const keyword_t keywords[] = {
     {"END", 0x80}, {"FOR", 0x81}, {"NEXT", 0x82}, {"DATA", 0x83},
     {"INPUT", 0x84}, {"DIM", 0x85}, {"READ", 0x86}, {"LET", 0x87},
@@ -32,9 +41,30 @@ static const keyword_t keywords[] = {
     {"COS", 0xB8}, {"SIN", 0xB9}, {"TAN", 0xBA}, {"ATN", 0xBB},
     {"PEEK", 0xBC}, {"LEN", 0xBD}, {"STR$", 0xBE}, {"VAL", 0xBF},
     {"ASC", 0xC0}, {"CHR$", 0xC1}, {"LEFT$", 0xC2}, {"RIGHT$", 0xC3},
-    {"MID$", 0xC4}, {NULL, 0}
+    {"MID$", 0xC4}, {"MAT", KW_MAT}, {"SUM", KW_SUM}, {"MIN", KW_MIN},
+    {"MAX", KW_MAX}, {"MEAN", KW_MEAN}, {"DOT", KW_DOT}, {"COUNT", KW_COUNT},
+    {"BSEARCH", KW_BSEARCH}, {"SORT", KW_SORT}, {"REDIM", KW_REDIM}, {"APPEND", KW_APPEND},
+    {"HASKEY", KW_HASKEY}, {"KEYS", KW_KEYS}, {"KEY$", KW_KEY}, {"LINE", KW_LINE},
+    {"EOF", KW_EOF}, {"OPEN", KW_OPEN}, {"CLOSE", KW_CLOSE}, {"LOF", KW_LOF},
+    {"BSAVE", KW_BSAVE}, {"BLOAD", KW_BLOAD},
+    {NULL, 0}
 };
 
+// 拡張キーワードの使われ方
+static keyword_use_t keyword_use(uint8_t id) {
+    switch (id) {
+        case KW_MAT: case KW_SORT: case KW_REDIM: case KW_APPEND: case KW_LINE:
+        case KW_OPEN: case KW_CLOSE: case KW_BSAVE: case KW_BLOAD:
+            return KEYWORD_STATEMENT;
+        case KW_SUM: case KW_MIN: case KW_MAX: case KW_MEAN: case KW_DOT: case KW_COUNT:
+        case KW_BSEARCH: case KW_HASKEY: case KW_KEYS: case KW_KEY: case KW_EOF:
+        case KW_LOF:
+            return KEYWORD_FUNCTION;
+        default:
+            return KEYWORD_RESERVED;
+    }
+}
+
 // パーサー状態
 // Disabled duplicate typedef; using basic.h's parser_state_t instead
 /*
@@ -52,6 +82,7 @@ static void init_parser(parser_state_t* parser, const char* text) {
     parser->position = 0;
     parser->length = strlen(text);
     parser->current_char = parser->length > 0 ? text[0] : '\0';
+    parser->line = NULL;
 }
 
 // 次の文字を取得
@@ -71,52 +102,36 @@ static void skip_whitespace(parser_state_t* parser) {
     }
 }
 
+// 以前の位置に戻る（先読みしたトークンを戻すとき）
+void parser_rewind(parser_state_t* parser, uint16_t position) {
+    if (!parser) return;
+    if (position > parser->length) position = parser->length;
+    parser->position = position;
+    parser->current_char = (parser->position < parser->length) ? parser->text[parser->position] : '\0';
+}
+
 // 数値の解析
 static bool parse_number(parser_state_t* parser, numeric_value_t* result) {
     if (!isdigit(parser->current_char) && parser->current_char != '.') {
         return false;
     }
     
-    double value = 0.0;
-    bool has_decimal = false;
-    double decimal_factor = 0.1;
-    
-    // 整数部
-    while (isdigit(parser->current_char)) {
-        value = value * 10.0 + (parser->current_char - '0');
-        advance_parser(parser);
-    }
-    
-    // 小数部
-    if (parser->current_char == '.') {
-        has_decimal = true;
-        advance_parser(parser);
-        while (isdigit(parser->current_char)) {
-            value += (parser->current_char - '0') * decimal_factor;
-            decimal_factor *= 0.1;
-            advance_parser(parser);
-        }
+    // 仮数・小数部・指数部をまとめて解析（正しく丸めた値になる）
+    const char* start = parser->text + parser->position;
+    const char* end = start;
+    double value = parse_decimal_literal(start, &end);
+    if (end == start) {
+        // "." だけは 0
+        value = 0.0;
+        end = start + 1;
     }
+    parser->position += (uint16_t)(end - start);
+    parser->current_char = (parser->position < parser->length) ? parser->text[parser->position] : '\0';
     
-    // 指数部
+    // 数字のない指数部の E と符号は読み捨てる
     if (parser->current_char == 'E' || parser->current_char == 'e') {
         advance_parser(parser);
-        bool negative_exp = false;
-        if (parser->current_char == '-') {
-            negative_exp = true;
-            advance_parser(parser);
-        } else if (parser->current_char == '+') {
-            advance_parser(parser);
-        }
-        
-        int exponent = 0;
-        while (isdigit(parser->current_char)) {
-            exponent = exponent * 10 + (parser->current_char - '0');
-            advance_parser(parser);
-        }
-        
-        if (negative_exp) exponent = -exponent;
-        value *= pow(10.0, exponent);
+        if (parser->current_char == '-' || parser->current_char == '+') advance_parser(parser);
     }
     
     *result = double_to_numeric(value);
@@ -124,11 +139,21 @@ static bool parse_number(parser_state_t* parser, numeric_value_t* result) {
 }
 
 // 文字列の解析
-static bool parse_string(parser_state_t* parser, char** result) {
+static bool parse_string(basic_state_t* state, parser_state_t* parser, char** result) {
     if (parser->current_char != '"') {
         return false;
     }
     
+    // プログラム行の定数はプールを複製せずに参照する
+    const program_line_t* line = parser->line;
+    if (line && line->literals && line->literals[parser->position] == '"') {
+        const char* literal = line->literals + parser->position + 1;
+        *result = (char*)literal;
+        parser->position = (uint16_t)(parser->position + strlen(literal) + 2);
+        parser->current_char = (parser->position < parser->length) ? parser->text[parser->position] : '\0';
+        return true;
+    }
+    
     advance_parser(parser); // 開始の"をスキップ
     
     uint16_t start_pos = parser->position;
@@ -144,13 +169,10 @@ static bool parse_string(parser_state_t* parser, char** result) {
         return false; // 閉じられていない文字列
     }
     
-    // 文字列をコピー
-    *result = (char*)malloc(length + 1);
+    // 文字列をコピー（一時領域）
+    *result = scratch_string(state, parser->text + start_pos, length);
     if (!*result) return false;
     
-    strncpy(*result, parser->text + start_pos, length);
-    (*result)[length] = '\0';
-    
     advance_parser(parser); // 終了の"をスキップ
     return true;
 }
@@ -188,13 +210,60 @@ static bool parse_variable(parser_state_t* parser, char* result) {
 }
 
 // キーワードの検索
-static uint8_t find_keyword(const char* word) {
+static const keyword_t* find_keyword(const char* word) {
     for (int i = 0; keywords[i].name; i++) {
         if (strcmp(word, keywords[i].name) == 0) {
-            return keywords[i].id;
+            return &keywords[i];
         }
     }
-    return 0;
+    return NULL;
+}
+
+// 現在位置の後の空白でない文字
+static char next_nonblank(const parser_state_t* parser) {
+    uint16_t p = parser->position;
+    while (p < parser->length && (parser->text[p] == ' ' || parser->text[p] == '\t')) p++;
+    return p < parser->length ? parser->text[p] : '\0';
+}
+
+// 現在位置の後（空白を除く）が単語 word か
+static bool word_after(const parser_state_t* parser, const char* word) {
+    size_t len = strlen(word);
+    uint16_t p = parser->position;
+    while (p < parser->length && (parser->text[p] == ' ' || parser->text[p] == '\t')) p++;
+    if ((size_t)(parser->length - p) < len || strncasecmp(parser->text + p, word, len) != 0) return false;
+    return p + len == parser->length || !isalnum((unsigned char)parser->text[p + len]);
+}
+
+// start の前（空白を除く）が単語 word か
+static bool word_before(const parser_state_t* parser, uint16_t start, const char* word) {
+    size_t len = strlen(word);
+    uint16_t p = start;
+    while (p > 0 && (parser->text[p - 1] == ' ' || parser->text[p - 1] == '\t')) p--;
+    if (p < len || strncasecmp(parser->text + p - len, word, len) != 0) return false;
+    return p == len || !isalnum((unsigned char)parser->text[p - len - 1]);
+}
+
+// start が文の先頭（行頭・: ・THEN の後）か
+static bool at_statement_start(const parser_state_t* parser, uint16_t start) {
+    uint16_t p = start;
+    while (p > 0 && (parser->text[p - 1] == ' ' || parser->text[p - 1] == '\t')) p--;
+    return p == 0 || parser->text[p - 1] == ':' || word_before(parser, start, "THEN");
+}
+
+// 読んだ単語をキーワードとして扱うか（start は単語の先頭、パーサーは単語の直後）
+static bool keyword_applies(const parser_state_t* parser, const keyword_t* keyword, uint16_t start) {
+    switch (keyword_use(keyword->id)) {
+        case KEYWORD_STATEMENT:
+            if (next_nonblank(parser) == '=') return false;
+            if (keyword->id == KW_APPEND && word_before(parser, start, "FOR")) return true; // OPEN ... FOR APPEND
+            if (keyword->id == KW_LINE && !word_after(parser, "INPUT")) return false;   // LINE INPUT
+            return at_statement_start(parser, start);
+        case KEYWORD_FUNCTION:
+            return next_nonblank(parser) == '(';
+        default:
+            return true;
+    }
 }
 
 // 次のトークンを取得
@@ -222,7 +291,7 @@ token_t get_next_token(basic_state_t* state, parser_state_t* parser) {
     // 文字列
     if (parser->current_char == '"') {
         token.type = TOKEN_STRING;
-        if (!parse_string(parser, &token.value.string)) {
+        if (!parse_string(state, parser, &token.value.string)) {
             set_error(state, ERR_SYNTAX, "Unterminated string");
         }
         return token;
@@ -243,16 +312,13 @@ token_t get_next_token(basic_state_t* state, parser_state_t* parser) {
         word[word_len] = '\0';
         
         // キーワードチェック
-        uint8_t keyword_id = find_keyword(word);
-        if (keyword_id) {
+        const keyword_t* keyword = find_keyword(word);
+        if (keyword && keyword_applies(parser, keyword, start_pos)) {
             token.type = TOKEN_KEYWORD;
-            token.value.keyword_id = keyword_id;
+            token.value.keyword_id = keyword->id;
         } else {
             token.type = TOKEN_VARIABLE;
-            token.value.string = (char*)malloc(strlen(word) + 1);
-            if (token.value.string) {
-                strcpy(token.value.string, word);
-            }
+            token.value.string = scratch_string(state, word, word_len);
         }
         return token;
     }
@@ -277,7 +343,7 @@ token_t get_next_token(basic_state_t* state, parser_state_t* parser) {
             }
             break;
             
-        case '(': case ')': case ',': case ';': case ':':
+        case '(': case ')': case ',': case ';': case ':': case '#':
             token.type = TOKEN_DELIMITER;
             token.value.operator = ch;
             break;
@@ -336,6 +402,9 @@ int basic_execute_line(basic_state_t* state, const char* line) {
     
     parser_state_t parser;
     init_parser(&parser, line);
+    if (state->current_line && state->current_line->text == line) {
+        parser.line = state->current_line;
+    }
     // If resuming mid-line (e.g., FOR/NEXT single-line), honor saved position
     if (state->current_position > 0) {
         if (state->current_position < parser.length) {
@@ -355,7 +424,10 @@ int basic_execute_line(basic_state_t* state, const char* line) {
         while (token.type == TOKEN_DELIMITER && token.value.operator == ':') {
             token = get_next_token(state, &parser);
         }
-        if (has_error(state)) return -1;
+        if (has_error(state)) {
+            arena_reset(&state->scratch);
+            return -1;
+        }
 
         int rc = 0;
         if (token.type == TOKEN_KEYWORD) {
@@ -383,6 +455,15 @@ int basic_execute_line(basic_state_t* state, const char* line) {
                 case 0x91: rc = cmd_null(state, &parser); break;           // NULL
                 case 0x95: rc = cmd_def(state, &parser); break;            // DEF
                 case 0x98: rc = cmd_cont(state, &parser); break;           // CONT
+                case 0xC5: rc = cmd_mat(state, &parser); break;            // MAT
+                case 0xCD: rc = cmd_sort(state, &parser); break;           // SORT
+                case 0xCE: rc = cmd_redim(state, &parser); break;          // REDIM
+                case 0xCF: rc = cmd_append(state, &parser); break;         // APPEND
+                case 0xD3: rc = cmd_line_input(state, &parser); break;     // LINE INPUT
+                case 0xD5: rc = cmd_open(state, &parser); break;           // OPEN
+                case 0xD6: rc = cmd_close(state, &parser); break;          // CLOSE
+                case 0xD8: rc = cmd_bsave(state, &parser); break;          // BSAVE
+                case 0xD9: rc = cmd_bload(state, &parser); break;          // BLOAD
                 case 0x9D: set_error(state, ERR_UNDEF_STATEMENT, "TAB not supported as statement"); rc = -1; break;
                 case 0x9E: case 0xA3: case 0xA1:
                     set_error(state, ERR_SYNTAX, "Misplaced keyword"); rc = -1; break;
@@ -398,8 +479,7 @@ int basic_execute_line(basic_state_t* state, const char* line) {
             // LET 省略対応: 変数で始まる行は代入文として扱う
             // トークン開始位置に巻き戻して LET パーサに委譲
             uint16_t rewind_pos = token.position;
-            parser.position = rewind_pos;
-            parser.current_char = (parser.position < parser.length) ? parser.text[parser.position] : '\0';
+            parser_rewind(&parser, rewind_pos);
             rc = cmd_let(state, &parser);
         } else if (token.type == TOKEN_EOF || token.type == TOKEN_EOL) {
             break;
@@ -408,6 +488,9 @@ int basic_execute_line(basic_state_t* state, const char* line) {
             rc = -1;
         }
 
+        // 文の終了: 式評価の一時領域を一括解放
+        arena_reset(&state->scratch);
+
         if (rc != 0 || has_error(state)) return rc;
 
         // After a statement, optionally consume ':' and continue; otherwise stop at EOL/EOF
@@ -417,8 +500,7 @@ int basic_execute_line(basic_state_t* state, const char* line) {
             continue; // next statement on the same line
         }
         // put back non-separator token
-        parser.position = save_pos;
-        parser.current_char = (parser.position < parser.length) ? parser.text[parser.position] : '\0';
+        parser_rewind(&parser, save_pos);
         break;
     }
 
@@ -430,19 +512,38 @@ int cmd_print(basic_state_t* state, parser_state_t* parser) {
     bool first = true;
     const int zone = 14; // Microsoft BASIC print zone width
 
+    // PRINT #n, ... writes the same text to a file channel with its own column
+    output_t* out = &state->output;
+    uint8_t* column = &state->trmpos;
+    uint16_t start = parser->position;
+    token_t hash = get_next_token(state, parser);
+    if (hash.type == TOKEN_DELIMITER && hash.value.operator == '#') {
+        file_channel_t* file = parse_file_channel(state, parser, true);
+        if (!file) return -1;
+        out = file->out;
+        column = &file->column;
+        uint16_t save = parser->position;
+        token_t comma = get_next_token(state, parser);
+        if (!(comma.type == TOKEN_DELIMITER && comma.value.operator == ',')) {
+            parser_rewind(parser, save);
+        }
+    } else {
+        parser_rewind(parser, start);
+    }
+
     // local helper to output and track terminal column
     auto void put_text_and_track(const char* s) {
         if (!s) return;
-        fputs(s, stdout);
         // update column position (naively count bytes)
         size_t n = strlen(s);
+        output_put(out, s, n);
         // wrap handling is omitted for simplicity; track modulo line width
-        state->trmpos = (uint8_t)((state->trmpos + (unsigned)n) % 255);
+        *column = (uint8_t)((*column + (unsigned)n) % 255);
     };
     auto void put_spaces_and_track(int n) {
         if (n <= 0) return;
-        for (int i = 0; i < n; i++) putchar(' ');
-        state->trmpos = (uint8_t)((state->trmpos + (unsigned)n) % 255);
+        output_put_spaces(out, n);
+        *column = (uint8_t)((*column + (unsigned)n) % 255);
     };
     while (1) {
         // Allow bare EOL
@@ -454,7 +555,7 @@ int cmd_print(basic_state_t* state, parser_state_t* parser) {
         // handle separators directly
         if (peek.type == TOKEN_DELIMITER && (peek.value.operator == ',' || peek.value.operator == ';')) {
             if (peek.value.operator == ',') {
-                int spaces = zone - (state->trmpos % zone);
+                int spaces = zone - (*column % zone);
                 if (spaces == 0) spaces = zone; // advance to next zone
                 put_spaces_and_track(spaces);
             } else {
@@ -476,7 +577,7 @@ int cmd_print(basic_state_t* state, parser_state_t* parser) {
             int target = (int)numeric_to_double(n.value.num);
             if (target < 0) target = 0;
             if (target > 255) target = 255;
-            int spaces = target - state->trmpos;
+            int spaces = target - *column;
             if (spaces > 0) put_spaces_and_track(spaces);
             first = false; trailing_semicolon = false; continue;
         }
@@ -494,17 +595,14 @@ int cmd_print(basic_state_t* state, parser_state_t* parser) {
             first = false; trailing_semicolon = false; continue;
         }
         // Not a simple separator: rewind and evaluate expression
-        parser->position = pos0;
-        parser->current_char = (parser->position < parser->length) ? parser->text[parser->position] : '\0';
+        parser_rewind(parser, pos0);
         eval_result_t val = evaluate_expression(state, parser);
         if (has_error(state)) return -1;
         if (val.type == 1) {
             put_text_and_track(val.value.str.data ? val.value.str.data : "");
-            if (val.value.str.data) free(val.value.str.data);
         } else {
-            char buf[64];
-            // emulate BASIC formatting loosely with %g
-            snprintf(buf, sizeof(buf), "%g", numeric_to_double(val.value.num));
+            char buf[NUMBER_FORMAT_SIZE];
+            format_number(val.value.num, buf);
             put_text_and_track(buf);
         }
         first = false; trailing_semicolon = false;
@@ -513,7 +611,7 @@ int cmd_print(basic_state_t* state, parser_state_t* parser) {
         token_t sep = get_next_token(state, parser);
         if (sep.type == TOKEN_DELIMITER && (sep.value.operator == ',' || sep.value.operator == ';')) {
             if (sep.value.operator == ',') {
-                int spaces = zone - (state->trmpos % zone);
+                int spaces = zone - (*column % zone);
                 if (spaces == 0) spaces = zone;
                 put_spaces_and_track(spaces);
                 trailing_semicolon = false;
@@ -524,15 +622,103 @@ int cmd_print(basic_state_t* state, parser_state_t* parser) {
             }
             continue;
         }
-        parser->position = save;
-        parser->current_char = (parser->position < parser->length) ? parser->text[parser->position] : '\0';
+        parser_rewind(parser, save);
         break;
     }
-    if (!trailing_semicolon) { putchar('\n'); state->trmpos = 0; }
+    if (!trailing_semicolon) { output_put(out, "\n", 1); *column = 0; }
     return 0;
 }
 
 
+// 追記する項の優先度: + と -（121）より強く * と /（123）より弱いので、各項は次の + か - の手前まで読む
+#define APPEND_TERM_PRECEDENCE 122
+
+// ロングストリングモードの追記代入 S$ = S$ + X$ [+ Y$ ...]
+// 右辺の各項をロープに追記するため、既存の文字列はコピーされない。
+// この形に該当しない場合は 1 を返し、パーサー位置は元に戻す
+static int let_append_rope(basic_state_t* state, parser_state_t* parser, const char* name) {
+    variable_t* var = find_variable(state, name);
+    if (!var || var->type != VAR_STRING) return 1;
+
+    uint16_t start = parser->position;
+    token_t self = get_next_token(state, parser);
+    bool same = (self.type == TOKEN_VARIABLE && find_variable(state, self.value.string) == var);
+    token_t plus = {0};
+    if (same) plus = get_next_token(state, parser);
+    if (!same || plus.type != TOKEN_OPERATOR || plus.value.operator != '+') {
+        parser_rewind(parser, start);
+        return 1;
+    }
+
+    // 項をすべて評価してから追記する（途中でエラーになっても変数は変更しない）
+    eval_result_t* terms = NULL;
+    size_t count = 0, capacity = 0;
+    int rc = 0;
+    while (true) {
+        eval_result_t term = evaluate_expression_with_precedence(state, parser, APPEND_TERM_PRECEDENCE);
+        if (has_error(state)) { rc = -1; break; }
+        if (count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : 8;
+            eval_result_t* grown = (eval_result_t*)arena_alloc(&state->scratch, new_capacity * sizeof(eval_result_t));
+            if (!grown) {
+                set_error(state, ERR_OUT_OF_MEMORY, NULL);
+                rc = -1;
+                break;
+            }
+            if (count > 0) memcpy(grown, terms, count * sizeof(eval_result_t));
+            terms = grown;
+            capacity = new_capacity;
+        }
+        terms[count++] = term;
+
+        uint16_t save = parser->position;
+        token_t next = get_next_token(state, parser);
+        if (next.type == TOKEN_OPERATOR && next.value.operator == '+') continue;
+        if (next.type == TOKEN_OPERATOR ||
+            (next.type == TOKEN_KEYWORD && (next.value.keyword_id == 0xA9 || next.value.keyword_id == 0xAA))) {
+            // 比較・論理演算が続く場合、右辺は数値になる
+            set_error(state, ERR_TYPE_MISMATCH, NULL);
+            rc = -1;
+            break;
+        }
+        parser_rewind(parser, save);
+        break;
+    }
+
+    if (rc == 0) {
+        // 数値項は文字列連結と同様に空文字列として扱う
+        size_t total = var->value.str.rope ? rope_length(var->value.str.rope)
+                                           : (var->value.str.data ? strlen(var->value.str.data) : 0);
+        // 長さは追記の前に測っておく（変数自身の項は追記先の葉を指していることがある）
+        for (size_t i = 0; i < count; i++) {
+            if (terms[i].type != 1 || !terms[i].value.str.data) continue;
+            terms[i].value.str.length = (uint32_t)strlen(terms[i].value.str.data);
+            total += terms[i].value.str.length;
+        }
+        if (total > MAX_LONG_STRING_LENGTH) {
+            set_error(state, ERR_STRING_TOO_LONG, NULL);
+            rc = -1;
+        } else if (!var->value.str.rope) {
+            var->value.str.rope = rope_from_string(&state->heap, var->value.str.data);
+            if (var->value.str.rope) {
+                var->value.str.data = NULL;
+            } else {
+                set_error(state, ERR_OUT_OF_MEMORY, NULL);
+                rc = -1;
+            }
+        }
+        for (size_t i = 0; rc == 0 && i < count; i++) {
+            if (terms[i].type != 1 || !terms[i].value.str.data) continue;
+            if (rope_append(var->value.str.rope, terms[i].value.str.data, terms[i].value.str.length) != 0) {
+                set_error(state, ERR_OUT_OF_MEMORY, NULL);
+                rc = -1;
+            }
+        }
+        var->value.str.length = (uint32_t)rope_length(var->value.str.rope);
+    }
+    return rc;
+}
+
 // 基本的なLETコマンド実装
 int cmd_let(basic_state_t* state, parser_state_t* parser) {
     token_t var_token = get_next_token(state, parser);
@@ -546,61 +732,61 @@ int cmd_let(basic_state_t* state, parser_state_t* parser) {
     uint16_t save_pos = parser->position;
     token_t next = get_next_token(state, parser);
     if (next.type == TOKEN_DELIMITER && next.value.operator == '(') {
-        uint16_t indices[MAX_ARRAY_DIMENSIONS];
-        uint8_t index_count = 0;
-        while (index_count < MAX_ARRAY_DIMENSIONS) {
-            eval_result_t idx = evaluate_expression(state, parser);
-            if (has_error(state) || idx.type != 0) { set_error(state, ERR_TYPE_MISMATCH, "Numeric index expected"); free(var_token.value.string); return -1; }
-            indices[index_count++] = (uint16_t)numeric_to_double(idx.value.num);
-            token_t sep = get_next_token(state, parser);
-            if (sep.type == TOKEN_DELIMITER && sep.value.operator == ',') {
-                continue;
-            } else if (sep.type == TOKEN_DELIMITER && sep.value.operator == ')') {
-                break;
-            } else {
-                set_error(state, ERR_SYNTAX, ", or ) expected in array assignment");
-                free(var_token.value.string);
-                return -1;
-            }
+        variable_t* array_var = find_variable(state, var_token.value.string);
+        if (array_var && (array_var->type == VAR_MAP_NUMERIC || array_var->type == VAR_MAP_STRING)) {
+            // 連想配列の要素: M(key$)=...
+            const char* key;
+            uint32_t key_length;
+            if (parse_map_key(state, parser, &key, &key_length) != 0) return -1;
+            token_t eq = get_next_token(state, parser);
+            if (eq.type != TOKEN_OPERATOR || eq.value.operator != '=') { set_error(state, ERR_SYNTAX, "= expected"); return -1; }
+            eval_result_t value = evaluate_expression(state, parser);
+            if (has_error(state)) return -1;
+            return assign_map_element(state, array_var, key, key_length, value);
         }
+        size_t indices[MAX_ARRAY_DIMENSIONS];
+        uint8_t index_count = 0;
+        if (parse_array_subscripts(state, parser, indices, &index_count) != 0) return -1;
         token_t eq2 = get_next_token(state, parser);
-        if (eq2.type != TOKEN_OPERATOR || eq2.value.operator != '=') { set_error(state, ERR_SYNTAX, "= expected"); free(var_token.value.string); return -1; }
+        if (eq2.type != TOKEN_OPERATOR || eq2.value.operator != '=') { set_error(state, ERR_SYNTAX, "= expected"); return -1; }
         eval_result_t value = evaluate_expression(state, parser);
-        if (has_error(state)) { free(var_token.value.string); return -1; }
-        int rc = assign_array_element(state, var_token.value.string, indices, index_count, value);
-        free(var_token.value.string);
-        return rc;
+        if (has_error(state)) return -1;
+        return assign_array_element(state, array_var, indices, index_count, value);
     }
     // Not an array: rewind and parse '=' and expression
-    parser->position = save_pos;
-    parser->current_char = (parser->position < parser->length) ? parser->text[parser->position] : '\0';
+    parser_rewind(parser, save_pos);
     
     token_t eq_token = get_next_token(state, parser);
     if (eq_token.type != TOKEN_OPERATOR || eq_token.value.operator != '=') {
         set_error(state, ERR_SYNTAX, "= expected");
-        free(var_token.value.string);
         return -1;
     }
     
+    bool is_string = strchr(var_token.value.string, '$') != NULL;
+    if (is_string && state->long_strings) {
+        int rc = let_append_rope(state, parser, var_token.value.string);
+        if (rc != 1) return rc;
+    }
+    
     eval_result_t value = evaluate_expression(state, parser);
-    if (has_error(state)) { free(var_token.value.string); return -1; }
+    if (has_error(state)) return -1;
     
-    bool is_string = strchr(var_token.value.string, '$') != NULL;
     variable_type_t var_type = is_string ? VAR_STRING : VAR_NUMERIC;
     variable_t* var = create_variable(state, var_token.value.string, var_type);
-    if (!var) { if (value.type==1 && value.value.str.data) free(value.value.str.data); free(var_token.value.string); return -1; }
+    if (!var) return -1;
     
     if (is_string) {
-        if (value.type != 1) { set_error(state, ERR_TYPE_MISMATCH, NULL); if (value.value.str.data) free(value.value.str.data); free(var_token.value.string); return -1; }
-        if (var->value.str.data) free(var->value.str.data);
-        var->value.str.data = value.value.str.data; // take ownership
-        var->value.str.length = var->value.str.data ? (uint16_t)strlen(var->value.str.data) : 0;
+        if (value.type != 1) { set_error(state, ERR_TYPE_MISMATCH, NULL); return -1; }
+        // 一時領域の値を変数用に複製
+        const char* text = value.value.str.data;
+        char* data = heap_string(state, text, text ? strlen(text) : 0);
+        if (!data) return -1;
+        variable_set_string(state, var, data);
     } else {
-        if (value.type != 0) { set_error(state, ERR_TYPE_MISMATCH, NULL); if (value.type==1 && value.value.str.data) free(value.value.str.data); free(var_token.value.string); return -1; }
+        if (value.type != 0) { set_error(state, ERR_TYPE_MISMATCH, NULL); return -1; }
         var->value.num = value.value.num;
     }
     
-    free(var_token.value.string);
     return 0;
 }
 
@@ -608,6 +794,9 @@ int cmd_let(basic_state_t* state, parser_state_t* parser) {
 int basic_run_program(basic_state_t* state) {
     if (!state) return -1;
     
+    // RUN は CLEAR を伴う（前回の実行の変数・スタック・DATAを破棄）
+    basic_clear_run_state(state);
+    if (scan_program_data(state) != 0) return -1;
     state->current_line = state->program_start;
     state->running = true;
     
@@ -622,6 +811,9 @@ int basic_run_program(basic_state_t* state) {
         }
     }
     
+    // 最後の行まで実行したら END と同じくファイルを閉じる
+    if (!state->current_line && !has_error(state)) close_all_files(state);
+    
     state->running = false;
     return has_error(state) ? -1 : 0;
 }
@@ -0,0 +1,216 @@
+#include "basic.h"
+
+// ロープ（長い文字列用の平衡木）
+//
+// ロングストリングモードの文字列変数は、チャンクを葉に持つAVL木として保持する。
+// S$ = S$ + X$ 形式の追記は右端の葉への書き込みか葉の追加で済むため、
+// 文字列全体をコピーせずに O(log n) で完了する。
+// ノードとチャンクは実行時アリーナのブロックとして確保する。
+
+#define ROPE_CHUNK_SIZE 4096
+
+struct rope_node {
+    size_t length;          // 部分木の総文字数
+    uint8_t height;         // 葉 = 1
+    struct rope_node* left;
+    struct rope_node* right;
+    char* chunk;            // 葉のみ: 文字データ（NUL終端）
+    size_t capacity;        // 葉のみ: chunk の確保サイズ
+};
+
+struct rope {
+    rope_node_t* root;
+    basic_arena_t* arena;
+};
+
+static bool node_is_leaf(const rope_node_t* n) {
+    return n->left == NULL && n->right == NULL;
+}
+
+static uint8_t node_height(const rope_node_t* n) {
+    return n ? n->height : 0;
+}
+
+static void node_update(rope_node_t* n) {
+    uint8_t hl = node_height(n->left);
+    uint8_t hr = node_height(n->right);
+    n->height = (uint8_t)((hl > hr ? hl : hr) + 1);
+    n->length = n->left->length + n->right->length;
+}
+
+// 葉の作成（chunk の所有権を受け取る）
+static rope_node_t* node_leaf(basic_arena_t* arena, char* chunk, size_t length, size_t capacity) {
+    rope_node_t* n = (rope_node_t*)arena_block_alloc(arena, sizeof(rope_node_t));
+    if (!n) return NULL;
+    memset(n, 0, sizeof(*n));
+    n->length = length;
+    n->height = 1;
+    n->chunk = chunk;
+    n->capacity = capacity;
+    return n;
+}
+
+// データをコピーして新しい葉を作成（小さな追記用に余裕を持たせる）
+static rope_node_t* node_leaf_copy(basic_arena_t* arena, const char* data, size_t length) {
+    size_t capacity = length + 1;
+    if (capacity < ROPE_CHUNK_SIZE) capacity = ROPE_CHUNK_SIZE;
+    char* chunk = (char*)arena_block_alloc(arena, capacity);
+    if (!chunk) return NULL;
+    memcpy(chunk, data, length);
+    chunk[length] = '\0';
+    rope_node_t* n = node_leaf(arena, chunk, length, capacity);
+    if (!n) arena_block_free(arena, chunk);
+    return n;
+}
+
+static rope_node_t* node_concat(basic_arena_t* arena, rope_node_t* left, rope_node_t* right) {
+    rope_node_t* n = (rope_node_t*)arena_block_alloc(arena, sizeof(rope_node_t));
+    if (!n) return NULL;
+    memset(n, 0, sizeof(*n));
+    n->left = left;
+    n->right = right;
+    node_update(n);
+    return n;
+}
+
+static rope_node_t* rotate_left(rope_node_t* n) {
+    rope_node_t* r = n->right;
+    n->right = r->left;
+    node_update(n);
+    r->left = n;
+    node_update(r);
+    return r;
+}
+
+static rope_node_t* rotate_right(rope_node_t* n) {
+    rope_node_t* l = n->left;
+    n->left = l->right;
+    node_update(n);
+    l->right = n;
+    node_update(l);
+    return l;
+}
+
+// AVL平衡の回復（回転は文字の並び順を保存する）
+static rope_node_t* node_rebalance(rope_node_t* n) {
+    node_update(n);
+    int balance = (int)node_height(n->left) - (int)node_height(n->right);
+    if (balance < -1) {
+        if (!node_is_leaf(n->right) &&
+            node_height(n->right->left) > node_height(n->right->right)) {
+            n->right = rotate_right(n->right);
+        }
+        return rotate_left(n);
+    }
+    if (balance > 1) {
+        if (!node_is_leaf(n->left) &&
+            node_height(n->left->right) > node_height(n->left->left)) {
+            n->left = rotate_left(n->left);
+        }
+        return rotate_right(n);
+    }
+    return n;
+}
+
+// 右端への追記。失敗時は NULL を返し、木は変更しない
+static rope_node_t* node_append(basic_arena_t* arena, rope_node_t* n, const char* data, size_t length) {
+    if (node_is_leaf(n)) {
+        if (n->capacity - n->length > length) {
+            memcpy(n->chunk + n->length, data, length);
+            n->length += length;
+            n->chunk[n->length] = '\0';
+            return n;
+        }
+        rope_node_t* leaf = node_leaf_copy(arena, data, length);
+        if (!leaf) return NULL;
+        rope_node_t* joined = node_concat(arena, n, leaf);
+        if (!joined) {
+            arena_block_free(arena, leaf->chunk);
+            arena_block_free(arena, leaf);
+        }
+        return joined;
+    }
+    rope_node_t* right = node_append(arena, n->right, data, length);
+    if (!right) return NULL;
+    n->right = right;
+    return node_rebalance(n);
+}
+
+static void node_free(basic_arena_t* arena, rope_node_t* n) {
+    if (!n) return;
+    node_free(arena, n->left);
+    node_free(arena, n->right);
+    if (n->chunk) arena_block_free(arena, n->chunk);
+    arena_block_free(arena, n);
+}
+
+static char* node_copy_out(const rope_node_t* n, char* dst) {
+    if (node_is_leaf(n)) {
+        memcpy(dst, n->chunk, n->length);
+        return dst + n->length;
+    }
+    dst = node_copy_out(n->left, dst);
+    return node_copy_out(n->right, dst);
+}
+
+// 文字列からロープを作成（アリーナのブロック data の所有権を受け取る。NULL可）
+rope_t* rope_from_string(basic_arena_t* arena, char* data) {
+    rope_t* rope = (rope_t*)arena_block_alloc(arena, sizeof(rope_t));
+    if (!rope) return NULL;
+    rope->root = NULL;
+    rope->arena = arena;
+    if (data) {
+        size_t length = strlen(data);
+        rope->root = node_leaf(arena, data, length, length + 1);
+        if (!rope->root) {
+            arena_block_free(arena, rope);
+            return NULL;
+        }
+    }
+    return rope;
+}
+
+// 追記
+int rope_append(rope_t* rope, const char* data, size_t length) {
+    if (!rope || length == 0) return 0;
+    rope_node_t* root = rope->root ? node_append(rope->arena, rope->root, data, length)
+                                   : node_leaf_copy(rope->arena, data, length);
+    if (!root) return -1;
+    rope->root = root;
+    return 0;
+}
+
+// 総文字数
+size_t rope_length(const rope_t* rope) {
+    return (rope && rope->root) ? rope->root->length : 0;
+}
+
+// 平坦化 - 連続したNUL終端文字列を返す
+// 結果は単一の葉として木に残るため、次の追記まで再計算は不要
+const char* rope_flatten(rope_t* rope) {
+    if (!rope) return NULL;
+    if (!rope->root) return "";
+    if (node_is_leaf(rope->root)) return rope->root->chunk;
+
+    size_t length = rope->root->length;
+    char* flat = (char*)arena_block_alloc(rope->arena, length + 1);
+    if (!flat) return NULL;
+    node_copy_out(rope->root, flat);
+    flat[length] = '\0';
+
+    rope_node_t* leaf = node_leaf(rope->arena, flat, length, length + 1);
+    if (!leaf) {
+        arena_block_free(rope->arena, flat);
+        return NULL;
+    }
+    node_free(rope->arena, rope->root);
+    rope->root = leaf;
+    return flat;
+}
+
+// 解放
+void rope_free(rope_t* rope) {
+    if (!rope) return;
+    node_free(rope->arena, rope->root);
+    arena_block_free(rope->arena, rope);
+}
@@ -0,0 +1,275 @@
+#include "basic.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// SORT文と BSEARCH 関数
+//
+//   SORT A [DESC] [, B, C$, ...]   A をキーに昇順（DESC なら降順）に並べ替え、
+//                                   続く配列も同じ順に並べ替える
+//   BSEARCH(A, x)                  昇順に整列済みの A から x を二分探索し、
+//                                   最初に一致した添字を返す（なければ -1）
+//
+// MAT文と同じく配列の全領域（添字0を含む）を1列の並びとして扱う。
+// 並べ替えは添字の順列に対する安定なマージソートで行い、最後に各配列へ適用する。
+// 文字列配列は共有領域内の文字列をそのまま比較し、移動はスロットの入れ替えだけで済ませる。
+
+#define SORT_MAX_ARRAYS      16     // キー配列を含めて一度に並べ替える配列の数
+#define INSERTION_SORT_MAX   16     // この要素数以下の区間は挿入ソート
+#define PARALLEL_SORT_MIN    65536  // この要素数以上ならスレッドで分割して整列
+#define SORT_MAX_THREADS     8
+
+typedef struct {
+    const variable_t* key;
+    bool descending;
+} sort_key_t;
+
+typedef struct {
+    const sort_key_t* key;
+    size_t* perm;
+    size_t* tmp;
+    size_t lo, mid, hi;
+} sort_task_t;
+
+static int compare_strings(const char* a, uint32_t la, const char* b, uint32_t lb) {
+    int c = memcmp(a, b, la < lb ? la : lb);
+    if (c != 0) return c;
+    return (la > lb) - (la < lb);
+}
+
+// キー配列の要素 a, b の比較
+static int compare_elements(const sort_key_t* key, size_t a, size_t b) {
+    int c;
+    if (key->key->type == VAR_ARRAY_NUMERIC) {
+        const double* v = (const double*)key->key->value.array.data;
+        c = (v[a] > v[b]) - (v[a] < v[b]);
+    } else {
+        uint32_t la, lb;
+        const char* sa = string_array_get(key->key, a, &la);
+        const char* sb = string_array_get(key->key, b, &lb);
+        c = compare_strings(sa, la, sb, lb);
+    }
+    return key->descending ? -c : c;
+}
+
+// src の [lo, mid) と [mid, hi) を dst へマージ（等しければ左側を先に置いて安定にする）
+static void merge_runs(const sort_key_t* key, const size_t* src, size_t* dst, size_t lo, size_t mid, size_t hi) {
+    size_t i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) {
+        dst[k++] = (compare_elements(key, src[j], src[i]) < 0) ? src[j++] : src[i++];
+    }
+    while (i < mid) dst[k++] = src[i++];
+    while (j < hi) dst[k++] = src[j++];
+}
+
+// perm[lo, hi) を整列（tmp は同じ範囲の作業領域）
+static void merge_sort(const sort_key_t* key, size_t* perm, size_t* tmp, size_t lo, size_t hi) {
+    if (hi - lo <= INSERTION_SORT_MAX) {
+        for (size_t i = lo + 1; i < hi; i++) {
+            size_t v = perm[i];
+            size_t j = i;
+            while (j > lo && compare_elements(key, perm[j - 1], v) > 0) {
+                perm[j] = perm[j - 1];
+                j--;
+            }
+            perm[j] = v;
+        }
+        return;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    merge_sort(key, perm, tmp, lo, mid);
+    merge_sort(key, perm, tmp, mid, hi);
+    if (compare_elements(key, perm[mid - 1], perm[mid]) <= 0) return; // 既に整列済み
+    memcpy(tmp + lo, perm + lo, (hi - lo) * sizeof(size_t));
+    merge_runs(key, tmp, perm, lo, mid, hi);
+}
+
+static void* sort_worker(void* arg) {
+    sort_task_t* task = (sort_task_t*)arg;
+    merge_sort(task->key, task->perm, task->tmp, task->lo, task->hi);
+    return NULL;
+}
+
+static void* merge_worker(void* arg) {
+    sort_task_t* task = (sort_task_t*)arg;
+    memcpy(task->tmp + task->lo, task->perm + task->lo, (task->hi - task->lo) * sizeof(size_t));
+    merge_runs(task->key, task->tmp, task->perm, task->lo, task->mid, task->hi);
+    return NULL;
+}
+
+// タスクを並行に実行（先頭は呼び出し元で処理し、スレッドを作れなければその場で処理）
+static void run_tasks(sort_task_t* tasks, size_t count, void* (*worker)(void*)) {
+    pthread_t threads[SORT_MAX_THREADS];
+    bool started[SORT_MAX_THREADS] = {false};
+    for (size_t i = 1; i < count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, worker, &tasks[i]) == 0;
+        if (!started[i]) worker(&tasks[i]);
+    }
+    worker(&tasks[0]);
+    for (size_t i = 1; i < count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+}
+
+static size_t sort_thread_count(size_t n) {
+    if (n < PARALLEL_SORT_MIN) return 1;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    return (size_t)cpus < SORT_MAX_THREADS ? (size_t)cpus : SORT_MAX_THREADS;
+}
+
+// 順列 perm[0, n) を整列 - 区間ごとにスレッドで整列し、隣り合う区間を段階的にマージする
+static void sort_permutation(const sort_key_t* key, size_t* perm, size_t* tmp, size_t n) {
+    size_t parts = sort_thread_count(n);
+    if (parts <= 1) {
+        merge_sort(key, perm, tmp, 0, n);
+        return;
+    }
+
+    size_t bounds[SORT_MAX_THREADS + 1];
+    for (size_t i = 0; i <= parts; i++) bounds[i] = n * i / parts;
+
+    sort_task_t tasks[SORT_MAX_THREADS];
+    for (size_t i = 0; i < parts; i++) {
+        tasks[i] = (sort_task_t){key, perm, tmp, bounds[i], bounds[i], bounds[i + 1]};
+    }
+    run_tasks(tasks, parts, sort_worker);
+
+    for (size_t width = 1; width < parts; width *= 2) {
+        size_t count = 0;
+        for (size_t i = 0; i + width < parts; i += 2 * width) {
+            size_t end = (i + 2 * width < parts) ? i + 2 * width : parts;
+            tasks[count++] = (sort_task_t){key, perm, tmp, bounds[i], bounds[i + width], bounds[end]};
+        }
+        run_tasks(tasks, count, merge_worker);
+    }
+}
+
+// 順列に従って配列の要素を並べ替える
+static int apply_permutation(basic_state_t* state, variable_t* var, const size_t* perm, size_t n) {
+    if (var->type == VAR_ARRAY_NUMERIC) {
+        numeric_value_t* values = (numeric_value_t*)var->value.array.data;
+        numeric_value_t* out = (numeric_value_t*)arena_alloc(&state->scratch, n * sizeof(numeric_value_t));
+        if (!out) { set_error(state, ERR_OUT_OF_MEMORY, NULL); return -1; }
+        for (size_t i = 0; i < n; i++) out[i] = values[perm[i]];
+        memcpy(values, out, n * sizeof(numeric_value_t));
+    } else {
+        string_slot_t* slots = (string_slot_t*)var->value.array.data;
+        string_slot_t* out = (string_slot_t*)arena_alloc(&state->scratch, n * sizeof(string_slot_t));
+        if (!out) { set_error(state, ERR_OUT_OF_MEMORY, NULL); return -1; }
+        for (size_t i = 0; i < n; i++) out[i] = slots[perm[i]];
+        memcpy(slots, out, n * sizeof(string_slot_t));
+    }
+    return 0;
+}
+
+// SORT文の実装
+int cmd_sort(basic_state_t* state, parser_state_t* parser) {
+    variable_t* arrays[SORT_MAX_ARRAYS];
+    size_t array_count = 0;
+
+    variable_t* key_var = resolve_array(state, get_next_token(state, parser), false);
+    if (!key_var) return -1;
+    arrays[array_count++] = key_var;
+    size_t n = key_var->value.array.total_elements;
+
+    sort_key_t key = {key_var, false};
+    uint16_t save = parser->position;
+    token_t token = get_next_token(state, parser);
+    if (token.type == TOKEN_VARIABLE && strcmp(token.value.string, "DESC") == 0) {
+        key.descending = true;
+        save = parser->position;
+        token = get_next_token(state, parser);
+    }
+
+    // 一緒に並べ替える配列
+    while (token.type == TOKEN_DELIMITER && token.value.operator == ',') {
+        variable_t* var = resolve_array(state, get_next_token(state, parser), false);
+        if (!var) return -1;
+        if (var->value.array.total_elements != n) {
+            set_error(state, ERR_SUBSCRIPT_OUT_OF_RANGE, "Array sizes do not match");
+            return -1;
+        }
+        bool listed = false;
+        for (size_t i = 0; i < array_count; i++) {
+            if (arrays[i] == var) listed = true;
+        }
+        if (!listed) {
+            if (array_count == SORT_MAX_ARRAYS) {
+                set_error(state, ERR_FORMULA_TOO_COMPLEX, "Too many arrays");
+                return -1;
+            }
+            arrays[array_count++] = var;
+        }
+        save = parser->position;
+        token = get_next_token(state, parser);
+    }
+    parser_rewind(parser, save);
+
+    size_t* perm = (size_t*)arena_alloc(&state->scratch, n * sizeof(size_t));
+    size_t* tmp = (size_t*)arena_alloc(&state->scratch, n * sizeof(size_t));
+    if (!perm || !tmp) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) perm[i] = i;
+    sort_permutation(&key, perm, tmp, n);
+
+    for (size_t i = 0; i < array_count; i++) {
+        if (apply_permutation(state, arrays[i], perm, n) != 0) return -1;
+    }
+    return 0;
+}
+
+// BSEARCH(A, x) - 開き括弧の直後から呼ばれ、閉じ括弧は呼び出し側で読む
+eval_result_t func_bsearch(basic_state_t* state, parser_state_t* parser) {
+    eval_result_t result = {0};
+    variable_t* var = resolve_array(state, get_next_token(state, parser), false);
+    if (!var) return result;
+
+    token_t comma = get_next_token(state, parser);
+    if (comma.type != TOKEN_DELIMITER || comma.value.operator != ',') {
+        set_error(state, ERR_SYNTAX, ", expected");
+        return result;
+    }
+    eval_result_t x = evaluate_expression(state, parser);
+    if (has_error(state)) return result;
+    bool numeric = (var->type == VAR_ARRAY_NUMERIC);
+    if (x.type != (numeric ? 0 : 1)) {
+        set_error(state, ERR_TYPE_MISMATCH, NULL);
+        return result;
+    }
+
+    // x 以上となる最初の要素を探す
+    size_t lo = 0, hi = var->value.array.total_elements;
+    double target = numeric ? numeric_to_double(x.value.num) : 0.0;
+    const double* values = (const double*)var->value.array.data;
+    uint32_t target_len = numeric ? 0 : x.value.str.length;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c;
+        if (numeric) {
+            c = (values[mid] > target) - (values[mid] < target);
+        } else {
+            uint32_t len;
+            const char* s = string_array_get(var, mid, &len);
+            c = compare_strings(s, len, x.value.str.data, target_len);
+        }
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    bool found = false;
+    if (lo < var->value.array.total_elements) {
+        if (numeric) {
+            found = (values[lo] == target);
+        } else {
+            uint32_t len;
+            const char* s = string_array_get(var, lo, &len);
+            found = (compare_strings(s, len, x.value.str.data, target_len) == 0);
+        }
+    }
+
+    result.type = 0;
+    result.value.num = double_to_numeric(found ? (double)lo : -1.0);
+    return result;
+}
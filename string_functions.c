@@ -30,50 +30,38 @@ eval_result_t func_asc(const char* str) {
 }
 
 // CHR$関数 - ASCIIコードから文字を生成
-eval_result_t func_chr(int ascii_code) {
+eval_result_t func_chr(basic_state_t* state, int ascii_code) {
     eval_result_t result;
     result.type = 1; // 文字列
     
     if (ascii_code < 0 || ascii_code > 255) {
         // 無効なASCIIコード
-        result.value.str.data = (char*)malloc(1);
-        if (result.value.str.data) {
-            result.value.str.data[0] = '\0';
-            result.value.str.length = 0;
-        }
-        return result;
-    }
-    
-    result.value.str.data = (char*)malloc(2);
-    if (!result.value.str.data) {
+        result.value.str.data = scratch_string(state, "", 0);
         result.value.str.length = 0;
         return result;
     }
     
-    result.value.str.data[0] = (char)ascii_code;
-    result.value.str.data[1] = '\0';
-    result.value.str.length = 1;
+    char ch = (char)ascii_code;
+    result.value.str.data = scratch_string(state, &ch, 1);
+    result.value.str.length = result.value.str.data ? 1 : 0;
     
     return result;
 }
 
 // STR$関数 - 数値を文字列に変換
-eval_result_t func_str(numeric_value_t num) {
+eval_result_t func_str(basic_state_t* state, numeric_value_t num) {
     eval_result_t result;
     result.type = 1; // 文字列
     
-    double val = numeric_to_double(num);
-    char temp[32];
+    char temp[NUMBER_FORMAT_SIZE + 1];
     
-    // 元のBASICの形式に合わせた数値表示
-    if (val >= 0) {
-        sprintf(temp, " %g", val); // 正数には先頭にスペース
-    } else {
-        sprintf(temp, "%g", val);
-    }
+    // 元のBASICの形式に合わせた数値表示（正数には先頭にスペース）
+    size_t length = 0;
+    if (numeric_to_double(num) >= 0) temp[length++] = ' ';
+    length += format_number(num, temp + length);
     
-    result.value.str.data = safe_string_dup(temp, MAX_STRING_LENGTH);
-    result.value.str.length = result.value.str.data ? strlen(result.value.str.data) : 0;
+    result.value.str.data = scratch_string(state, temp, length);
+    result.value.str.length = result.value.str.data ? (uint32_t)length : 0;
     
     return result;
 }
@@ -98,150 +86,104 @@ eval_result_t func_val(const char* str) {
     }
     
     // 数値部分のみを解析
-    char* endptr;
-    double val = strtod(str, &endptr);
-    
-    result.value.num = double_to_numeric(val);
+    result.value.num = double_to_numeric(parse_decimal(str, NULL));
     return result;
 }
 
 // LEFT$関数 - 文字列の左側から指定文字数を取得
-eval_result_t func_left(const char* str, int n) {
+eval_result_t func_left(basic_state_t* state, const char* str, int n) {
     eval_result_t result;
     result.type = 1; // 文字列
     
     if (!str || n <= 0) {
-        result.value.str.data = (char*)malloc(1);
-        if (result.value.str.data) {
-            result.value.str.data[0] = '\0';
-            result.value.str.length = 0;
-        }
-        return result;
-    }
-    
-    int str_len = strlen(str);
-    int copy_len = (n > str_len) ? str_len : n;
-    
-    result.value.str.data = (char*)malloc(copy_len + 1);
-    if (!result.value.str.data) {
+        result.value.str.data = scratch_string(state, "", 0);
         result.value.str.length = 0;
         return result;
     }
     
-    strncpy(result.value.str.data, str, copy_len);
-    result.value.str.data[copy_len] = '\0';
-    result.value.str.length = copy_len;
+    size_t str_len = strlen(str);
+    size_t copy_len = ((size_t)n > str_len) ? str_len : (size_t)n;
+    
+    result.value.str.data = scratch_string(state, str, copy_len);
+    result.value.str.length = result.value.str.data ? (uint32_t)copy_len : 0;
     
     return result;
 }
 
 // RIGHT$関数 - 文字列の右側から指定文字数を取得
-eval_result_t func_right(const char* str, int n) {
+eval_result_t func_right(basic_state_t* state, const char* str, int n) {
     eval_result_t result;
     result.type = 1; // 文字列
     
     if (!str || n <= 0) {
-        result.value.str.data = (char*)malloc(1);
-        if (result.value.str.data) {
-            result.value.str.data[0] = '\0';
-            result.value.str.length = 0;
-        }
-        return result;
-    }
-    
-    int str_len = strlen(str);
-    int start_pos = (n >= str_len) ? 0 : str_len - n;
-    int copy_len = str_len - start_pos;
-    
-    result.value.str.data = (char*)malloc(copy_len + 1);
-    if (!result.value.str.data) {
+        result.value.str.data = scratch_string(state, "", 0);
         result.value.str.length = 0;
         return result;
     }
     
-    strcpy(result.value.str.data, str + start_pos);
-    result.value.str.length = copy_len;
+    size_t str_len = strlen(str);
+    size_t start_pos = ((size_t)n >= str_len) ? 0 : str_len - (size_t)n;
+    size_t copy_len = str_len - start_pos;
+    
+    result.value.str.data = scratch_string(state, str + start_pos, copy_len);
+    result.value.str.length = result.value.str.data ? (uint32_t)copy_len : 0;
     
     return result;
 }
 
 // MID$関数 - 文字列の中間部分を取得
-eval_result_t func_mid(const char* str, int start, int len) {
+eval_result_t func_mid(basic_state_t* state, const char* str, int start, int len) {
     eval_result_t result;
     result.type = 1; // 文字列
     
-    if (!str || start < 1 || len <= 0) {
-        result.value.str.data = (char*)malloc(1);
-        if (result.value.str.data) {
-            result.value.str.data[0] = '\0';
-            result.value.str.length = 0;
-        }
-        return result;
-    }
-    
-    int str_len = strlen(str);
-    int start_pos = start - 1; // BASICは1ベース
+    size_t str_len = str ? strlen(str) : 0;
+    size_t start_pos = (start >= 1) ? (size_t)(start - 1) : 0; // BASICは1ベース
     
-    if (start_pos >= str_len) {
+    if (!str || start < 1 || len <= 0 || start_pos >= str_len) {
         // 開始位置が文字列長を超えている
-        result.value.str.data = (char*)malloc(1);
-        if (result.value.str.data) {
-            result.value.str.data[0] = '\0';
-            result.value.str.length = 0;
-        }
-        return result;
-    }
-    
-    int available_len = str_len - start_pos;
-    int copy_len = (len > available_len) ? available_len : len;
-    
-    result.value.str.data = (char*)malloc(copy_len + 1);
-    if (!result.value.str.data) {
+        result.value.str.data = scratch_string(state, "", 0);
         result.value.str.length = 0;
         return result;
     }
     
-    strncpy(result.value.str.data, str + start_pos, copy_len);
-    result.value.str.data[copy_len] = '\0';
-    result.value.str.length = copy_len;
+    size_t available_len = str_len - start_pos;
+    size_t copy_len = ((size_t)len > available_len) ? available_len : (size_t)len;
+    
+    result.value.str.data = scratch_string(state, str + start_pos, copy_len);
+    result.value.str.length = result.value.str.data ? (uint32_t)copy_len : 0;
     
     return result;
 }
 
-// 文字列連結
-eval_result_t string_concatenate(const char* str1, const char* str2) {
+// 文字列連結（結果は一時領域に置かれる）
+eval_result_t string_concatenate(basic_state_t* state, const char* str1, const char* str2) {
     eval_result_t result;
     result.type = 1; // 文字列
     
-    int len1 = str1 ? strlen(str1) : 0;
-    int len2 = str2 ? strlen(str2) : 0;
-    int total_len = len1 + len2;
+    size_t len1 = str1 ? strlen(str1) : 0;
+    size_t len2 = str2 ? strlen(str2) : 0;
+    size_t total_len = len1 + len2;
+    size_t max_len = string_limit(state);
     
-    if (total_len > MAX_STRING_LENGTH) {
-        total_len = MAX_STRING_LENGTH;
+    if (total_len > max_len) {
+        total_len = max_len;
     }
     
-    result.value.str.data = (char*)malloc(total_len + 1);
+    result.value.str.data = (char*)arena_alloc(&state->scratch, total_len + 1);
     if (!result.value.str.data) {
+        set_error(state, ERR_OUT_OF_MEMORY, NULL);
         result.value.str.length = 0;
         return result;
     }
     
-    result.value.str.data[0] = '\0';
+    size_t copy_len1 = (len1 > total_len) ? total_len : len1;
+    if (copy_len1 > 0) memcpy(result.value.str.data, str1, copy_len1);
     
-    if (str1 && len1 > 0) {
-        int copy_len1 = (len1 > total_len) ? total_len : len1;
-        strncpy(result.value.str.data, str1, copy_len1);
-        result.value.str.data[copy_len1] = '\0';
-    }
-    
-    if (str2 && len2 > 0 && len1 < total_len) {
-        int remaining = total_len - len1;
-        int copy_len2 = (len2 > remaining) ? remaining : len2;
-        strncat(result.value.str.data, str2, copy_len2);
-    }
+    size_t copy_len2 = total_len - copy_len1;
+    if (copy_len2 > 0) memcpy(result.value.str.data + copy_len1, str2, copy_len2);
     
-    result.value.str.length = strlen(result.value.str.data);
+    result.value.str.data[total_len] = '\0';
+    result.value.str.length = (uint32_t)total_len;
     return result;
 }
 
@@ -11,7 +11,7 @@ extern token_t get_next_token(basic_state_t* state, parser_state_t* parser);
 extern eval_result_t evaluate_expression(basic_state_t* state, parser_state_t* parser);
 
 // 仮想メモリ（元の6502メモリをシミュレート）
-static uint8_t virtual_memory[65536];
+static uint8_t virtual_memory[VIRTUAL_MEMORY_SIZE];
 static bool memory_initialized = false;
 
 // メモリ初期化
@@ -22,6 +22,12 @@ void init_virtual_memory(void) {
     }
 }
 
+// 仮想メモリの先頭（BSAVE/BLOAD）
+uint8_t* virtual_memory_base(void) {
+    init_virtual_memory();
+    return virtual_memory;
+}
+
 // PEEK関数 - メモリ読み取り
 numeric_value_t func_peek(uint16_t address) {
     init_virtual_memory();
@@ -96,35 +102,26 @@ int cmd_input(basic_state_t* state, parser_state_t* parser_ptr) {
         } else {
             // プロンプトなし、変数として扱う
             has_prompt = false;
-            free(prompt_text);
             prompt_text = NULL;
         }
     }
     
-    // プロンプト表示
-    if (has_prompt && prompt_text) {
-        printf("%s", prompt_text);
-        free(prompt_text);
-    } else {
-        printf("? ");
+    // プロンプト表示（端末から読むときだけ）
+    if (state->input.interactive) {
+        if (has_prompt && prompt_text) {
+            output_text(state, prompt_text);
+        } else {
+            output_text(state, "? ");
+        }
     }
-    fflush(stdout);
     
-    // 入力読み取り
-    if (!fgets(state->input_buffer, sizeof(state->input_buffer), stdin)) {
-        set_error(state, ERR_SYNTAX, "Input error");
+    // 入力読み取り（行は入力領域の中にあり、その場で区切る）
+    char* input_ptr = input_read_line(state, &state->input, NULL);
+    if (!input_ptr) {
+        if (!has_error(state)) set_error(state, ERR_INPUT_PAST_END, NULL);
         return -1;
     }
     
-    // 改行文字を削除
-    size_t len = strlen(state->input_buffer);
-    if (len > 0 && state->input_buffer[len - 1] == '\n') {
-        state->input_buffer[len - 1] = '\0';
-    }
-    
-    // 入力データの解析
-    char* input_ptr = state->input_buffer;
-    
     while (true) {
         token_t var_token;
         if (!has_prompt) {
@@ -162,32 +159,25 @@ int cmd_input(basic_state_t* state, parser_state_t* parser_ptr) {
         
         variable_t* var = create_variable(state, var_token.value.string, var_type);
         if (!var) {
-            free(var_token.value.string);
             return -1;
         }
         
         if (is_string) {
-            if (var->value.str.data) free(var->value.str.data);
-            var->value.str.data = (char*)malloc(strlen(value_str) + 1);
-            if (var->value.str.data) {
-                strcpy(var->value.str.data, value_str);
-                var->value.str.length = strlen(value_str);
-            }
+            char* data = heap_string(state, value_str, strlen(value_str));
+            if (!data) return -1;
+            variable_set_string(state, var, data);
         } else {
             // strict numeric parse: require entire field to be a number
-            char* endptr = NULL;
-            double v = strtod(value_str, &endptr);
+            const char* endptr = NULL;
+            double v = parse_decimal(value_str, &endptr);
             while (endptr && *endptr && isspace((unsigned char)*endptr)) endptr++;
             if (!endptr || *endptr != '\0' || strlen(value_str) == 0) {
                 set_error(state, ERR_TYPE_MISMATCH, "Numeric expected");
-                free(var_token.value.string);
                 return -1;
             }
             var->value.num = double_to_numeric(v);
         }
         
-        free(var_token.value.string);
-        
         // 次の変数があるかチェック
         token_t next_token = get_next_token(state, parser_ptr);
         if (next_token.type == TOKEN_DELIMITER && next_token.value.operator == ',') {
@@ -204,40 +194,8 @@ int cmd_input(basic_state_t* state, parser_state_t* parser_ptr) {
 int cmd_clear(basic_state_t* state, parser_state_t* parser_ptr) {
     (void)parser_ptr; // 未使用パラメータ
     
-    // 変数の解放
-    variable_t* var = state->variables;
-    while (var) {
-        variable_t* next = var->next;
-        if (var->type == VAR_STRING && var->value.str.data) {
-            free(var->value.str.data);
-        } else if (var->type == VAR_ARRAY_NUMERIC || var->type == VAR_ARRAY_STRING) {
-            if (var->value.array.data) free(var->value.array.data);
-            if (var->value.array.dimensions) free(var->value.array.dimensions);
-        }
-        free(var);
-        var = next;
-    }
-    state->variables = NULL;
-    
-    // スタックのクリア
-    for_stack_entry_t* for_entry = state->for_stack;
-    while (for_entry) {
-        for_stack_entry_t* next = for_entry->next;
-        free(for_entry);
-        for_entry = next;
-    }
-    state->for_stack = NULL;
-    
-    gosub_stack_entry_t* gosub_entry = state->gosub_stack;
-    while (gosub_entry) {
-        gosub_stack_entry_t* next = gosub_entry->next;
-        free(gosub_entry);
-        gosub_entry = next;
-    }
-    state->gosub_stack = NULL;
-    
-    // データ状態のクリア
-    cleanup_data_state();
+    // 変数・スタック・データ状態のクリア
+    basic_clear_run_state(state);
     
     return 0;
 }
@@ -247,7 +205,8 @@ int cmd_stop(basic_state_t* state, parser_state_t* parser_ptr) {
     (void)parser_ptr; // 未使用パラメータ
     
     state->running = false;
-    printf("BREAK IN %d\n", state->current_line ? state->current_line->line_number : 0);
+    output_printf(state, "BREAK IN %d\n", state->current_line ? state->current_line->line_number : 0);
+    output_flush(state);
     
     return 0;
 }
@@ -257,7 +216,8 @@ int cmd_end(basic_state_t* state, parser_state_t* parser_ptr) {
     (void)parser_ptr; // 未使用パラメータ
     
     state->running = false;
-    return 0;
+    output_flush(state);
+    return close_all_files(state);
 }
 
 // CONT文の実装
@@ -343,9 +303,10 @@ int cmd_get(basic_state_t* state, parser_state_t* parser_ptr) {
         return -1;
     }
     
-    // 1文字入力
-    int ch = getchar();
-    if (ch == EOF) ch = 0;
+    // 1文字入力（入力の終わりは 0）
+    int ch = input_read_char(state, &state->input);
+    if (has_error(state)) return -1;
+    if (ch < 0) ch = 0;
     
     // 変数への代入
     bool is_string = strchr(var_token.value.string, '$') != NULL;
@@ -353,23 +314,18 @@ int cmd_get(basic_state_t* state, parser_state_t* parser_ptr) {
     
     variable_t* var = create_variable(state, var_token.value.string, var_type);
     if (!var) {
-        free(var_token.value.string);
         return -1;
     }
     
     if (is_string) {
-        if (var->value.str.data) free(var->value.str.data);
-        var->value.str.data = (char*)malloc(2);
-        if (var->value.str.data) {
-            var->value.str.data[0] = (char)ch;
-            var->value.str.data[1] = '\0';
-            var->value.str.length = 1;
-        }
+        char c = (char)ch;
+        char* data = heap_string(state, &c, 1);
+        if (!data) return -1;
+        variable_set_string(state, var, data);
     } else {
         var->value.num = double_to_numeric((double)ch);
     }
     
-    free(var_token.value.string);
     return 0;
 }
 
@@ -398,7 +354,7 @@ int cmd_null(basic_state_t* state, parser_state_t* parser_ptr) {
     
     // NULL文字の出力（実際の実装では端末制御）
     for (int i = 0; i < null_count; i++) {
-        putchar('\0');
+        output_char(state, '\0');
     }
     
     return 0;
@@ -406,11 +362,9 @@ int cmd_null(basic_state_t* state, parser_state_t* parser_ptr) {
 
 // システム情報の取得
 void get_system_info(basic_state_t* state) {
-    (void)state; // 未使用パラメータ
-    
-    printf("Microsoft BASIC M6502 v1.1 (C Port)\n");
-    printf("Memory: %zu bytes free\n", (size_t)32768);
-    printf("Variables: %d defined\n", count_variables(state));
+    output_printf(state, "%s\n", BASIC_VERSION_STRING);
+    output_printf(state, "Memory: %zu bytes free\n", (size_t)32768);
+    output_printf(state, "Variables: %d defined\n", count_variables(state));
 }
 
 // 変数数のカウント
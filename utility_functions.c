@@ -1,36 +1,227 @@
 #include "basic.h"
 
 // 文字列の安全な複製
-char* safe_string_dup(const char* src, uint16_t max_len) {
+char* safe_string_dup(const char* src, size_t max_len) {
     if (!src) return NULL;
     
-    uint16_t len = strlen(src);
+    size_t len = strlen(src);
     if (len > max_len) len = max_len;
     
     char* result = (char*)malloc(len + 1);
     if (!result) return NULL;
     
-    strncpy(result, src, len);
+    memcpy(result, src, len);
     result[len] = '\0';
     return result;
 }
 
-// 数値の文字列変換
-char* number_to_string(numeric_value_t n) {
-    double val = numeric_to_double(n);
-    char* result = (char*)malloc(32);
-    if (!result) return NULL;
-    
-    // 元のBASICの形式に合わせた数値表示
-    if (val == floor(val) && fabs(val) < 1e9) {
-        // 整数として表示
-        sprintf(result, "%.0f", val);
+// 一時文字列の確保
+// 式評価中の中間文字列は一時領域アリーナに置き、文の終了時にまとめて解放される。
+// 変数に格納する場合は heap_string() で複製すること
+char* scratch_string(basic_state_t* state, const char* src, size_t len) {
+    char* result = arena_strndup(&state->scratch, src ? src : "", src ? len : 0);
+    if (!result) set_error(state, ERR_OUT_OF_MEMORY, NULL);
+    return result;
+}
+
+// 変数・配列・DATAが保持する文字列の確保（実行時アリーナ、文字列長の上限で切り詰め）
+char* heap_string(basic_state_t* state, const char* src, size_t len) {
+    if (!src) len = 0;
+    if (len > string_limit(state)) len = string_limit(state);
+    char* result = arena_block_strndup(&state->heap, src ? src : "", len);
+    if (!result) set_error(state, ERR_OUT_OF_MEMORY, NULL);
+    return result;
+}
+
+// 文字列長の上限（ロングストリングモードでは拡張）
+size_t string_limit(basic_state_t* state) {
+    return (state && state->long_strings) ? MAX_LONG_STRING_LENGTH : MAX_STRING_LENGTH;
+}
+
+// ---- 数値の書式化（PRINT・STR$・DATA で共用）----
+//
+// 整数で絶対値が 1e9 未満ならすべての桁を、それ以外は有効数字6桁で
+// printf の %g と同じ形（末尾の 0 は省き、指数が -5 未満か 6 以上なら e 表記）にする。
+// 通常は倍精度の演算だけで桁を求め、丸めが際どいとき（半端がほぼ 0.5）と
+// 範囲外の値だけ snprintf に任せる。
+
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// 符号なし整数の10進表記（終端付き、長さを返す）
+static size_t format_digits(uint64_t value, char* buf) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (size_t i = 0; i < count; i++) buf[i] = digits[count - 1 - i];
+    buf[count] = '\0';
+    return count;
+}
+
+// 有効数字6桁の %g 相当（a > 0）、求められなければ 0 を返す
+static size_t format_general(double a, char* buf) {
+    if (!(a >= 1e-5 && a < 1e16)) return 0;
+    int exponent = (int)floor(log10(a));
+    int shift = 5 - exponent;
+    double scaled = (shift >= 0) ? a * pow10_table[shift] : a / pow10_table[-shift];
+    if (scaled < 1e5 || scaled >= 1e6) {
+        // log10 の誤差で指数が1ずれていた
+        int adjust = (scaled < 1e5) ? -1 : 1;
+        exponent += adjust;
+        shift -= adjust;
+        scaled = (shift >= 0) ? a * pow10_table[shift] : a / pow10_table[-shift];
+    }
+    double whole = floor(scaled);
+    double fraction = scaled - whole;
+    if (fabs(fraction - 0.5) < 1e-6) return 0; // 丸めの向きが演算誤差で変わりうる
+    uint32_t mantissa = (uint32_t)whole + (fraction > 0.5 ? 1 : 0);
+    if (mantissa >= 1000000) {
+        mantissa /= 10;
+        exponent++;
+    }
+    if (mantissa < 100000 || mantissa >= 1000000) return 0;
+
+    char digits[8];
+    format_digits(mantissa, digits);
+    int significant = 6;
+    while (significant > 1 && digits[significant - 1] == '0') significant--;
+
+    size_t n = 0;
+    if (exponent < -4 || exponent >= 6) {
+        // 指数表記 d.ddddde±XX
+        buf[n++] = digits[0];
+        if (significant > 1) {
+            buf[n++] = '.';
+            for (int i = 1; i < significant; i++) buf[n++] = digits[i];
+        }
+        buf[n++] = 'e';
+        buf[n++] = exponent < 0 ? '-' : '+';
+        int e = abs(exponent);
+        buf[n++] = (char)('0' + e / 10);
+        buf[n++] = (char)('0' + e % 10);
+    } else if (exponent >= 0) {
+        // 整数部 exponent+1 桁、残りが小数部
+        for (int i = 0; i <= exponent; i++) buf[n++] = digits[i];
+        if (significant > exponent + 1) {
+            buf[n++] = '.';
+            for (int i = exponent + 1; i < significant; i++) buf[n++] = digits[i];
+        }
     } else {
-        // 浮動小数点として表示
-        sprintf(result, "%g", val);
+        buf[n++] = '0';
+        buf[n++] = '.';
+        for (int i = exponent + 1; i < 0; i++) buf[n++] = '0';
+        for (int i = 0; i < significant; i++) buf[n++] = digits[i];
     }
-    
-    return result;
+    buf[n] = '\0';
+    return n;
+}
+
+// 数値の書式化（buf は NUMBER_FORMAT_SIZE バイト以上、長さを返す）
+size_t format_number(numeric_value_t num, char* buf) {
+    double val = numeric_to_double(num);
+    double a = fabs(val);
+    char* p = buf;
+    if (signbit(val) && !isnan(val)) *p++ = '-';
+
+    if (a < 1e9 && a == floor(a)) {
+        // 整数
+        return (size_t)(p - buf) + format_digits((uint64_t)a, p);
+    }
+    size_t n = format_general(a, p);
+    if (n > 0) return (size_t)(p - buf) + n;
+    return (size_t)snprintf(buf, NUMBER_FORMAT_SIZE, "%g", val);
+}
+
+// ---- 数値の解析（定数・INPUT・READ・VAL で共用）----
+//
+// strtod と同じ引数・結果の10進数の解析。仮数が19桁以内で2^53以下、
+// 10の指数が ±22 以内なら、どちらも正確に表せる2つの値の積か商を1回だけ丸めて
+// 正しく丸めた値が求まる（Clinger の方法）。それ以外（桁の多すぎる値、極端な指数）は
+// strtod に任せる。INPUT・READ・VAL では strtod と同じく 16進数・INF・NAN も読むが、
+// プログラム中の定数（parse_decimal_literal）は10進数だけ（0X10 は 0 と X10）。
+
+#define FAST_MANTISSA_LIMIT (1ULL << 53)
+#define MAX_MANTISSA_DIGITS 19
+
+static double scan_decimal(const char* text, const char** end, bool literal) {
+    const char* p = text;
+    while (*p == ' ' || *p == '\t') p++;
+    bool negative = (*p == '-');
+    if (*p == '-' || *p == '+') p++;
+    if (!literal && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) return strtod(text, (char**)end); // 16進数
+
+    uint64_t mantissa = 0;
+    int digits = 0;          // 仮数に取り込んだ有効桁数
+    int exponent = 0;
+    bool any_digit = false;
+    bool overflow = false;   // 有効桁が多すぎる
+    for (; *p >= '0' && *p <= '9'; p++) {
+        any_digit = true;
+        if (digits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            if (mantissa != 0) digits++;
+        } else {
+            overflow = true;
+        }
+    }
+    if (*p == '.') {
+        for (p++; *p >= '0' && *p <= '9'; p++) {
+            any_digit = true;
+            if (digits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            } else {
+                overflow = true;
+            }
+        }
+    }
+    if (!any_digit) {
+        if (!literal) return strtod(text, (char**)end); // INF・NAN
+        if (end) *end = text;
+        return 0.0;
+    }
+    if (*p == 'E' || *p == 'e') {
+        const char* q = p + 1;
+        bool negative_exp = (*q == '-');
+        if (*q == '-' || *q == '+') q++;
+        if (*q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; *q >= '0' && *q <= '9'; q++) {
+                if (e < 100000) e = e * 10 + (*q - '0');
+            }
+            exponent += negative_exp ? -e : e;
+            p = q;
+        }
+    }
+
+    double value;
+    if (mantissa == 0) {
+        value = 0.0;
+    } else if (!overflow && mantissa <= FAST_MANTISSA_LIMIT && exponent >= -22 && exponent <= 22) {
+        value = (double)mantissa;
+        value = (exponent < 0) ? value / pow10_table[-exponent] : value * pow10_table[exponent];
+    } else if (!overflow && exponent == 0) {
+        value = (double)mantissa; // 整数への変換は正しく丸められる
+    } else {
+        return strtod(text, (char**)end);
+    }
+    if (end) *end = p;
+    return negative ? -value : value;
+}
+
+double parse_decimal(const char* text, const char** end) {
+    return scan_decimal(text, end, false);
+}
+
+// プログラム中の定数用（10進数のみ）
+double parse_decimal_literal(const char* text, const char** end) {
+    return scan_decimal(text, end, true);
 }
 
 // 文字列の数値変換
@@ -44,10 +235,7 @@ numeric_value_t string_to_number(const char* str) {
     if (*str == '\0') return double_to_numeric(0.0);
     
     // 数値部分のみを解析
-    char* endptr;
-    double val = strtod(str, &endptr);
-    
-    return double_to_numeric(val);
+    return double_to_numeric(parse_decimal(str, NULL));
 }
 
 // 数値変換関数
@@ -0,0 +1,370 @@
+#include "basic.h"
+
+// ベクトル演算カーネル（MAT文と配列関数で共用）
+//
+// 配列は numeric_value_t（実体は double）の連続領域なので、double 列として処理する。
+// x86 では AVX2 版を実行時に選択し、それ以外は SSE2 版、非x86 ではスカラー版を使う。
+// 丸め結果を環境によらず揃えるため FMA は使わない。
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VEC_HAVE_AVX2 1
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define VEC_HAVE_SSE2 1
+#endif
+
+#ifdef VEC_HAVE_AVX2
+// AVX2 が使えるか（初回のみ判定）
+static bool cpu_has_avx2(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        __builtin_cpu_init();
+        cached = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return cached == 1;
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+// ---- 加算 dst = a + b ----
+
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static void add_avx2(double* dst, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < n; i++) dst[i] = a[i] + b[i];
+}
+#endif
+
+static void add_default(double* dst, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+#endif
+    for (; i < n; i++) dst[i] = a[i] + b[i];
+}
+
+void vec_add(double* dst, const double* a, const double* b, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) { add_avx2(dst, a, b, n); return; }
+#endif
+    add_default(dst, a, b, n);
+}
+
+// ---- 減算 dst = a - b ----
+
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static void sub_avx2(double* dst, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < n; i++) dst[i] = a[i] - b[i];
+}
+#endif
+
+static void sub_default(double* dst, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(dst + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+#endif
+    for (; i < n; i++) dst[i] = a[i] - b[i];
+}
+
+void vec_sub(double* dst, const double* a, const double* b, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) { sub_avx2(dst, a, b, n); return; }
+#endif
+    sub_default(dst, a, b, n);
+}
+
+// ---- スカラー倍 dst = k * a ----
+
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static void scale_avx2(double* dst, const double* a, double k, size_t n) {
+    __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(vk, _mm256_loadu_pd(a + i)));
+    }
+    for (; i < n; i++) dst[i] = k * a[i];
+}
+#endif
+
+static void scale_default(double* dst, const double* a, double k, size_t n) {
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    __m128d vk = _mm_set1_pd(k);
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(dst + i, _mm_mul_pd(vk, _mm_loadu_pd(a + i)));
+    }
+#endif
+    for (; i < n; i++) dst[i] = k * a[i];
+}
+
+void vec_scale(double* dst, const double* a, double k, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) { scale_avx2(dst, a, k, n); return; }
+#endif
+    scale_default(dst, a, k, n);
+}
+
+// ---- 積和 dst += k * x ----
+
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static void axpy_avx2(double* dst, double k, const double* x, size_t n) {
+    __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d prod = _mm256_mul_pd(vk, _mm256_loadu_pd(x + i));
+        _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i), prod));
+    }
+    for (; i < n; i++) dst[i] += k * x[i];
+}
+#endif
+
+static void axpy_default(double* dst, double k, const double* x, size_t n) {
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    __m128d vk = _mm_set1_pd(k);
+    for (; i + 2 <= n; i += 2) {
+        __m128d prod = _mm_mul_pd(vk, _mm_loadu_pd(x + i));
+        _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(dst + i), prod));
+    }
+#endif
+    for (; i < n; i++) dst[i] += k * x[i];
+}
+
+void vec_axpy(double* dst, double k, const double* x, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) { axpy_avx2(dst, k, x, n); return; }
+#endif
+    axpy_default(dst, k, x, n);
+}
+
+// ---- 行列積 dst(m×p) = a(m×n) * b(n×p) ----
+// i-k-j 順にして内側のループを連続な行に対する積和にする。dst は a, b と重ならないこと
+void mat_multiply(double* dst, const double* a, const double* b, size_t m, size_t n, size_t p) {
+    memset(dst, 0, m * p * sizeof(double));
+    for (size_t i = 0; i < m; i++) {
+        double* row = dst + i * p;
+        for (size_t k = 0; k < n; k++) {
+            double aik = a[i * n + k];
+            if (aik != 0.0) vec_axpy(row, aik, b + k * p, p);
+        }
+    }
+}
+
+// ---- 転置 dst(cols×rows) = a(rows×cols)ᵀ ----
+// キャッシュ効率のためブロック単位で処理する。dst は a と重ならないこと
+#define TRANSPOSE_BLOCK 32
+
+void mat_transpose(double* dst, const double* a, size_t rows, size_t cols) {
+    for (size_t ib = 0; ib < rows; ib += TRANSPOSE_BLOCK) {
+        size_t iend = ib + TRANSPOSE_BLOCK < rows ? ib + TRANSPOSE_BLOCK : rows;
+        for (size_t jb = 0; jb < cols; jb += TRANSPOSE_BLOCK) {
+            size_t jend = jb + TRANSPOSE_BLOCK < cols ? jb + TRANSPOSE_BLOCK : cols;
+            for (size_t i = ib; i < iend; i++) {
+                for (size_t j = jb; j < jend; j++) {
+                    dst[j * rows + i] = a[i * cols + j];
+                }
+            }
+        }
+    }
+}
+
+// ---- 集約（SUM / DOT / MIN / MAX / COUNT） ----
+// 合計と内積は、どの実装でも「4レーンの部分和 → (s0+s1)+(s2+s3) → 端数を順に加算」
+// という同じ順序で計算し、AVX2 の有無で結果が変わらないようにする。
+
+static double combine_lanes(const double lanes[4]) {
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static double sum_avx2(const double* a, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm256_add_pd(acc, _mm256_loadu_pd(a + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double s = combine_lanes(lanes);
+    for (; i < n; i++) s += a[i];
+    return s;
+}
+
+AVX2_TARGET static double dot_avx2(const double* a, const double* b, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double s = combine_lanes(lanes);
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+#endif
+
+static double sum_default(const double* a, size_t n) {
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    __m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        lo = _mm_add_pd(lo, _mm_loadu_pd(a + i));
+        hi = _mm_add_pd(hi, _mm_loadu_pd(a + i + 2));
+    }
+    _mm_storeu_pd(lanes, lo);
+    _mm_storeu_pd(lanes + 2, hi);
+#else
+    for (; i + 4 <= n; i += 4) {
+        for (int j = 0; j < 4; j++) lanes[j] += a[i + j];
+    }
+#endif
+    double s = combine_lanes(lanes);
+    for (; i < n; i++) s += a[i];
+    return s;
+}
+
+static double dot_default(const double* a, const double* b, size_t n) {
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    __m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    _mm_storeu_pd(lanes, lo);
+    _mm_storeu_pd(lanes + 2, hi);
+#else
+    for (; i + 4 <= n; i += 4) {
+        for (int j = 0; j < 4; j++) lanes[j] += a[i + j] * b[i + j];
+    }
+#endif
+    double s = combine_lanes(lanes);
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+double vec_sum(const double* a, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) return sum_avx2(a, n);
+#endif
+    return sum_default(a, n);
+}
+
+double vec_dot(const double* a, const double* b, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) return dot_avx2(a, b, n);
+#endif
+    return dot_default(a, b, n);
+}
+
+// 最小値・最大値（n >= 1 であること）
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static void minmax_avx2(const double* a, size_t n, double* min_out, double* max_out) {
+    __m256d vmin = _mm256_set1_pd(a[0]);
+    __m256d vmax = vmin;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(a + i);
+        vmin = _mm256_min_pd(vmin, v);
+        vmax = _mm256_max_pd(vmax, v);
+    }
+    double lo[4], hi[4];
+    _mm256_storeu_pd(lo, vmin);
+    _mm256_storeu_pd(hi, vmax);
+    double mn = lo[0], mx = hi[0];
+    for (int j = 1; j < 4; j++) {
+        if (lo[j] < mn) mn = lo[j];
+        if (hi[j] > mx) mx = hi[j];
+    }
+    for (; i < n; i++) {
+        if (a[i] < mn) mn = a[i];
+        if (a[i] > mx) mx = a[i];
+    }
+    *min_out = mn;
+    *max_out = mx;
+}
+#endif
+
+static void minmax_default(const double* a, size_t n, double* min_out, double* max_out) {
+    double mn = a[0], mx = a[0];
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    __m128d vmin = _mm_set1_pd(a[0]);
+    __m128d vmax = vmin;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(a + i);
+        vmin = _mm_min_pd(vmin, v);
+        vmax = _mm_max_pd(vmax, v);
+    }
+    double lo[2], hi[2];
+    _mm_storeu_pd(lo, vmin);
+    _mm_storeu_pd(hi, vmax);
+    mn = lo[0] < lo[1] ? lo[0] : lo[1];
+    mx = hi[0] > hi[1] ? hi[0] : hi[1];
+#endif
+    for (; i < n; i++) {
+        if (a[i] < mn) mn = a[i];
+        if (a[i] > mx) mx = a[i];
+    }
+    *min_out = mn;
+    *max_out = mx;
+}
+
+void vec_minmax(const double* a, size_t n, double* min_out, double* max_out) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) { minmax_avx2(a, n, min_out, max_out); return; }
+#endif
+    minmax_default(a, n, min_out, max_out);
+}
+
+// value と等しい要素の個数
+#ifdef VEC_HAVE_AVX2
+AVX2_TARGET static size_t count_avx2(const double* a, double value, size_t n) {
+    __m256d vv = _mm256_set1_pd(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(a + i), vv, _CMP_EQ_OQ));
+        count += (size_t)__builtin_popcount((unsigned)mask);
+    }
+    for (; i < n; i++) if (a[i] == value) count++;
+    return count;
+}
+#endif
+
+static size_t count_default(const double* a, double value, size_t n) {
+    size_t count = 0;
+    size_t i = 0;
+#ifdef VEC_HAVE_SSE2
+    __m128d vv = _mm_set1_pd(value);
+    for (; i + 2 <= n; i += 2) {
+        int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(a + i), vv));
+        count += (size_t)((mask & 1) + (mask >> 1));
+    }
+#endif
+    for (; i < n; i++) if (a[i] == value) count++;
+    return count;
+}
+
+size_t vec_count_equal(const double* a, double value, size_t n) {
+#ifdef VEC_HAVE_AVX2
+    if (cpu_has_avx2()) return count_avx2(a, value, n);
+#endif
+    return count_default(a, value, n);
+}